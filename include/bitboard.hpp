@@ -0,0 +1,365 @@
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/// @brief  Defined when the BMI2 PEXT slider path can be compiled for this target
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_PEXT_PATH
+#endif
+
+/// @brief  64-bit set of squares, bit 0 is a1, bit 7 is h1, bit 63 is h8
+typedef uint64_t Bitboard;
+
+/// @brief  Number of squares on the board
+#define SQUARE_NB 64
+/// @brief  Marker for "no square"
+#define NO_SQUARE -1
+
+/**
+ * @brief  Get the square index of a file/rank pair
+ * @param  file: The file (0 for 'a' ... 7 for 'h')
+ * @param  rank: The rank (0 for '1' ... 7 for '8')
+ * @return The square index (0-63)
+ */
+constexpr int squareOf(int file, int rank) { return rank * 8 + file; }
+
+/// @brief  Get the file (0-7) of a square index
+constexpr int fileOf(int square) { return square & 7; }
+
+/// @brief  Get the rank (0-7) of a square index
+constexpr int rankOf(int square) { return square >> 3; }
+
+/// @brief  Get a bitboard with only the given square set
+constexpr Bitboard squareBB(int square) { return Bitboard(1) << square; }
+
+/**
+ * @brief  Count the set bits of a bitboard
+ * @param  b: The bitboard
+ * @return The number of squares in the set
+ */
+inline int popCount(Bitboard b)
+{
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+/**
+ * @brief  Get the lowest set square of a non-empty bitboard
+ * @param  b: The bitboard, must not be 0
+ * @return The square index of the least significant bit
+ */
+inline int lsb(Bitboard b)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+/**
+ * @brief  Remove and return the lowest set square of a non-empty bitboard
+ * @param  b: The bitboard, must not be 0
+ * @return The square index that was removed
+ */
+inline int popLsb(Bitboard& b)
+{
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+/**
+ * @brief  Extract the bits of a value selected by a mask (BMI2 PEXT)
+ * Only call it when Attacks::sliderPath() is Attacks::PEXT, the CPU must support BMI2.
+ * Inline assembly keeps it inlinable without building the whole program with -mbmi2.
+ * @param  value: The bits to extract from
+ * @param  mask: The bits to extract
+ * @return The selected bits packed towards bit 0
+ */
+inline Bitboard pext(Bitboard value, Bitboard mask)
+{
+#if defined(_MSC_VER) && defined(HAS_PEXT_PATH)
+    return _pext_u64(value, mask);
+#elif defined(HAS_PEXT_PATH)
+    Bitboard result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+    return result;
+#else
+    (void)value;
+    (void)mask;
+    return 0;
+#endif
+}
+
+/// @brief  Board directions as (file, rank) steps, indexes of Attacks::ray.
+///         Opposite directions differ only in the lowest bit
+namespace Direction {
+    enum Dir {
+        NORTH = 0,
+        SOUTH = 1,
+        EAST = 2,
+        WEST = 3,
+        NORTH_EAST = 4,
+        SOUTH_WEST = 5,
+        NORTH_WEST = 6,
+        SOUTH_EAST = 7
+    };
+
+    /// @brief  File step of every direction
+    constexpr int fileStep[8] = { 0, 0, 1, -1, 1, -1, -1, 1 };
+    /// @brief  Rank step of every direction
+    constexpr int rankStep[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+}
+
+/// @brief  Compile-time generators of the leaper, ray, between and line tables
+namespace AttackGen {
+    typedef std::array<Bitboard, SQUARE_NB> SquareTable;
+    typedef std::array<SquareTable, SQUARE_NB> PairTable;
+
+    /**
+     * @brief  Get a square from a file/rank pair that may be off the board
+     * @return The square bitboard, or 0 if off the board
+     */
+    constexpr Bitboard safeSquareBB(int file, int rank) {
+        return (file >= 0 && file < 8 && rank >= 0 && rank < 8) ? squareBB(squareOf(file, rank)) : 0;
+    }
+
+    /**
+     * @brief  Walk one ray from a square, stopping on the first occupied square
+     * @param  square: The starting square (0-63), not included
+     * @param  direction: The direction, check Direction for reference
+     * @param  occupied: The blocking squares
+     * @return The ray squares, first blocker included
+     */
+    constexpr Bitboard rayAttacks(int square, int direction, Bitboard occupied) {
+        Bitboard attacks = 0;
+        int file = fileOf(square) + Direction::fileStep[direction];
+        int rank = rankOf(square) + Direction::rankStep[direction];
+        while (Bitboard bb = safeSquareBB(file, rank)) {
+            attacks |= bb;
+            if (occupied & bb) {
+                break;
+            }
+            file += Direction::fileStep[direction];
+            rank += Direction::rankStep[direction];
+        }
+        return attacks;
+    }
+
+    /// @brief  Get the squares a bishop attacks by walking its rays, see rayAttacks
+    constexpr Bitboard bishopRays(int square, Bitboard occupied) {
+        return rayAttacks(square, Direction::NORTH_EAST, occupied) | rayAttacks(square, Direction::NORTH_WEST, occupied)
+             | rayAttacks(square, Direction::SOUTH_EAST, occupied) | rayAttacks(square, Direction::SOUTH_WEST, occupied);
+    }
+
+    /// @brief  Get the squares a rook attacks by walking its rays, see rayAttacks
+    constexpr Bitboard rookRays(int square, Bitboard occupied) {
+        return rayAttacks(square, Direction::NORTH, occupied) | rayAttacks(square, Direction::SOUTH, occupied)
+             | rayAttacks(square, Direction::EAST, occupied) | rayAttacks(square, Direction::WEST, occupied);
+    }
+
+    constexpr SquareTable knightTable() {
+        SquareTable table = {};
+        const int steps[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+        for (int square = 0; square < SQUARE_NB; square++) {
+            for (int i = 0; i < 8; i++) {
+                table[square] |= safeSquareBB(fileOf(square) + steps[i][0], rankOf(square) + steps[i][1]);
+            }
+        }
+        return table;
+    }
+
+    constexpr SquareTable kingTable() {
+        SquareTable table = {};
+        for (int square = 0; square < SQUARE_NB; square++) {
+            for (int direction = 0; direction < 8; direction++) {
+                table[square] |= safeSquareBB(fileOf(square) + Direction::fileStep[direction], rankOf(square) + Direction::rankStep[direction]);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<SquareTable, 2> pawnTable() {
+        std::array<SquareTable, 2> table = {};
+        for (int square = 0; square < SQUARE_NB; square++) {
+            table[0][square] = safeSquareBB(fileOf(square) - 1, rankOf(square) + 1) | safeSquareBB(fileOf(square) + 1, rankOf(square) + 1);
+            table[1][square] = safeSquareBB(fileOf(square) - 1, rankOf(square) - 1) | safeSquareBB(fileOf(square) + 1, rankOf(square) - 1);
+        }
+        return table;
+    }
+
+    constexpr std::array<SquareTable, 8> rayTable() {
+        std::array<SquareTable, 8> table = {};
+        for (int direction = 0; direction < 8; direction++) {
+            for (int square = 0; square < SQUARE_NB; square++) {
+                table[direction][square] = rayAttacks(square, direction, 0);
+            }
+        }
+        return table;
+    }
+
+    /**
+     * @brief  Build the between or line table
+     * @param  line: true for full lines through both squares, false for the squares strictly between
+     */
+    constexpr PairTable pairTable(bool line) {
+        PairTable table = {};
+        for (int from = 0; from < SQUARE_NB; from++) {
+            for (int direction = 0; direction < 8; direction++) {
+                Bitboard walked = 0;
+                Bitboard ray = rayAttacks(from, direction, 0);
+                Bitboard fullLine = ray | rayAttacks(from, direction ^ 1, 0) | squareBB(from);
+                int file = fileOf(from) + Direction::fileStep[direction];
+                int rank = rankOf(from) + Direction::rankStep[direction];
+                while (Bitboard bb = safeSquareBB(file, rank)) {
+                    table[from][squareOf(file, rank)] = line ? fullLine : walked;
+                    walked |= bb;
+                    file += Direction::fileStep[direction];
+                    rank += Direction::rankStep[direction];
+                }
+            }
+        }
+        return table;
+    }
+}
+
+/// @brief  Precomputed attack tables. Leaper, ray, between and line tables are built
+///         at compile time; slider tables are filled on first use, see init()
+namespace Attacks {
+    /// @brief  Slider lookup implementations, picked at startup from CPUID
+    enum SliderPath {
+        MAGIC = 0, // Portable magic multiply
+        PEXT = 1   // BMI2 parallel bit extract, only on CPUs where it is fast
+    };
+
+    /// @brief  Magic bitboard entry of one square for one slider kind
+    struct Magic {
+        Bitboard mask;         // Relevant occupancy, board edges excluded
+        Bitboard magic;        // Multiplier mapping the relevant occupancy to a table index
+        Bitboard* attacks;     // This square's slice of the magic-indexed attack table
+        Bitboard* pextAttacks; // This square's slice of the PEXT-indexed attack table
+        unsigned shift;        // 64 minus the number of relevant squares
+
+        /// @brief  Get the magic table index of an occupancy
+        unsigned index(Bitboard occupied) const {
+            return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+        }
+
+        /// @brief  Get the attacks of an occupancy through the given path
+        Bitboard lookup(Bitboard occupied, bool usePext) const {
+            return usePext ? pextAttacks[pext(occupied, mask)] : attacks[index(occupied)];
+        }
+    };
+
+    /// @brief  True when the PEXT path is in use, read on every slider lookup.
+    ///         Atomic so setSliderPath may race with lookups; relaxed loads are plain loads on x86
+    extern std::atomic<bool> usePext;
+
+    /// @brief  Squares attacked by a knight, indexed by square
+    inline constexpr AttackGen::SquareTable knight = AttackGen::knightTable();
+    /// @brief  Squares attacked by a king, indexed by square
+    inline constexpr AttackGen::SquareTable king = AttackGen::kingTable();
+    /// @brief  Squares attacked by a pawn, indexed by [color][square]
+    inline constexpr std::array<AttackGen::SquareTable, 2> pawn = AttackGen::pawnTable();
+    /// @brief  Empty-board ray from a square, indexed by [Direction][square], square excluded
+    inline constexpr std::array<AttackGen::SquareTable, 8> ray = AttackGen::rayTable();
+    /// @brief  Squares strictly between two aligned squares, 0 if not aligned
+    inline constexpr AttackGen::PairTable between = AttackGen::pairTable(false);
+    /// @brief  Full board line through two aligned squares, 0 if not aligned
+    inline constexpr AttackGen::PairTable line = AttackGen::pairTable(true);
+
+    static_assert(knight[0] == 0x0000000000020400ULL, "knight attacks from a1");
+    static_assert(knight[28] == 0x0000284400442800ULL, "knight attacks from e4");
+    static_assert(king[0] == 0x0000000000000302ULL, "king attacks from a1");
+    static_assert(king[63] == 0x40C0000000000000ULL, "king attacks from h8");
+    static_assert(pawn[0][28] == 0x0000002800000000ULL, "white pawn attacks from e4");
+    static_assert(pawn[1][28] == 0x0000000000280000ULL, "black pawn attacks from e4");
+    static_assert(pawn[0][8] == 0x0000000000020000ULL, "white pawn attacks from a2 stay on the board");
+    static_assert(ray[Direction::NORTH][0] == 0x0101010101010100ULL, "north ray from a1");
+    static_assert(ray[Direction::SOUTH_WEST][63] == 0x0040201008040201ULL, "south-west ray from h8");
+    static_assert(between[0][63] == 0x0040201008040200ULL, "between a1 and h8");
+    static_assert(between[0][56] == 0x0001010101010100ULL, "between a1 and a8");
+    static_assert(between[0][17] == 0, "a1 and b3 are not aligned");
+    static_assert(between[0][1] == 0, "nothing between adjacent squares");
+    static_assert(line[9][18] == 0x8040201008040201ULL, "line through b2 and c3");
+    static_assert(line[0][17] == 0, "no line through a1 and b3");
+
+    /// @brief  Bishop magic entries, indexed by square
+    extern Magic bishopMagics[SQUARE_NB];
+    /// @brief  Rook magic entries, indexed by square
+    extern Magic rookMagics[SQUARE_NB];
+
+    /**
+     * @brief  Fill the slider tables and pick the lookup path, only the first call does any work
+     * Every ChessBoard constructor calls it, so boards defined at namespace scope work in any
+     * link order. Call it before bishop() or rook() when no board has been constructed yet.
+     */
+    void init();
+
+    /**
+     * @brief  Check whether this CPU has a fast BMI2 PEXT instruction
+     * @return false if BMI2 is missing or microcoded (AMD before Zen 3)
+     */
+    bool cpuHasFastPext();
+
+    /**
+     * @brief  Get the slider lookup path in use
+     * @return The current path, check SliderPath for reference
+     */
+    SliderPath sliderPath();
+
+    /**
+     * @brief  Force a slider lookup path, e.g. to benchmark both on one machine
+     * Safe to call while other threads generate moves, they switch on their next lookup.
+     * @param  path: The path to use, check SliderPath for reference
+     * @return false if the path is not supported by this CPU, the current path is kept
+     */
+    bool setSliderPath(SliderPath path);
+
+    /**
+     * @brief  Compare every slider table entry against a slow ray walk, and the
+     *         PEXT table against the magic table when the CPU supports PEXT
+     * @return true if every lookup path returns identical attacks
+     */
+    bool selfCheck();
+
+    /**
+     * @brief  Get the squares attacked by a bishop
+     * @param  square: The bishop square (0-63)
+     * @param  occupied: Every occupied square of the board
+     * @return The attacked squares, up to and including the first blocker of each ray
+     */
+    inline Bitboard bishop(int square, Bitboard occupied) {
+        return bishopMagics[square].lookup(occupied, usePext.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief  Get the squares attacked by a rook
+     * @param  square: The rook square (0-63)
+     * @param  occupied: Every occupied square of the board
+     * @return The attacked squares, up to and including the first blocker of each ray
+     */
+    inline Bitboard rook(int square, Bitboard occupied) {
+        return rookMagics[square].lookup(occupied, usePext.load(std::memory_order_relaxed));
+    }
+
+    /// @brief  Get the squares attacked by a queen, see bishop() and rook()
+    inline Bitboard queen(int square, Bitboard occupied) {
+        return bishop(square, occupied) | rook(square, occupied);
+    }
+}
+
+#endif // BITBOARD_HPP
@@ -0,0 +1,42 @@
+#ifndef BOARD_DIFF_HPP
+#define BOARD_DIFF_HPP
+
+#include <chess.hpp>
+
+/// @brief  Comparison of two positions, used to resync a game from an external FEN
+namespace BoardDiff {
+    /**
+     * @brief  Get every square whose piece differs between two mailboxes
+     * Piece states are ignored, only the color and kind are compared. On x86-64 the
+     * AVX2 path is picked at runtime from CPUID, like the PEXT slider path, with SSE2
+     * as the fallback; other targets compare 8 squares per word.
+     * @param  before: The 64 pieces of the first position, see ChessBoard::squares
+     * @param  after: The 64 pieces of the second position
+     * @return The changed squares
+     */
+    Bitboard changedSquares(const Piece* before, const Piece* after);
+
+    /// @brief  Get every square whose piece differs between two boards, see above
+    inline Bitboard changedSquares(const ChessBoard& before, const ChessBoard& after) {
+        return changedSquares(before.squares(), after.squares());
+    }
+
+    /**
+     * @brief  Find the move that turned one position into another
+     * Only legal moves of the side to move in before are considered, castling, en passant
+     * and promotions included. Every candidate is checked square by square, so the
+     * placements must match exactly; side to move and counters of after are not compared.
+     * @param  before: The position before the move
+     * @param  after: The position after the move
+     * @return The move, or Move::none() if no single legal move explains the difference
+     */
+    Move inferMove(const ChessBoard& before, const ChessBoard& after);
+
+    /**
+     * @brief  Get the instruction set changedSquares uses on this machine
+     * @return "avx2", "sse2" or "scalar"
+     */
+    const char* implementation();
+}
+
+#endif // BOARD_DIFF_HPP
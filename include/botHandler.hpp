@@ -28,8 +28,8 @@ using namespace std;
 using namespace nlohmann;
 
 // Function declarations
-string encodeFen(const string& fen);
+string encodeFen(string_view fen);
 string httpsGet(const string& host, const string& port, const string& target);
-void getBotMove(ChessBoard* Board);
+bool getBotMove(ChessBoard* Board);
 
 #endif
\ No newline at end of file
@@ -1,9 +1,15 @@
 #ifndef PIECE_HPP
 #define PIECE_HPP
 
+#include <cassert>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include <functional>
+
+#include <bitboard.hpp>
 
 using namespace std;
 
@@ -31,6 +37,49 @@ namespace PieceType {
     };
 }
 
+/// @brief  Piece kinds regardless of color, used to index the bitboards
+namespace PieceKind {
+    enum Kind {
+        PAWN = 0,
+        KNIGHT = 1,
+        BISHOP = 2,
+        ROOK = 3,
+        QUEEN = 4,
+        KING = 5,
+
+        NONE = 6
+    };
+}
+
+/// @brief  Material values in centipawns and game phase weights, indexed by PieceKind
+namespace PieceValue {
+    constexpr int material[6] = { 100, 320, 330, 500, 900, 0 };
+    constexpr int phase[6] = { 0, 1, 1, 2, 4, 0 };
+}
+
+/// @brief  Game phase of the starting material, see ChessBoard::phase
+#define MAX_PHASE 24
+
+/// @brief  Piece colors, used to index the bitboards
+namespace PieceColor {
+    enum Color {
+        WHITE = 0,
+        BLACK = 1
+    };
+}
+
+/// @brief  Castling rights as bits, matching wck/wcq/bck/bcq
+namespace CastlingRight {
+    enum Right {
+        WHITE_KING_SIDE = 1,
+        WHITE_QUEEN_SIDE = 2,
+        BLACK_KING_SIDE = 4,
+        BLACK_QUEEN_SIDE = 8,
+
+        ALL = 15
+    };
+}
+
 /// @brief  Piece states in chess
 namespace PieceState {
     enum State {
@@ -43,13 +92,13 @@ namespace PieceState {
     };
 }
 
-/// @brief Represents a chess piece and the chess board
+/// @brief Represents a chess piece and the chess board.
+///        A piece is a plain value without identity: equal codes are interchangeable and
+///        en passant is tracked by square, so boards on different threads share nothing.
 class Piece
 {
     private:
-        char _type;
-        char _state;
-        int _id;
+        uint8_t _code; // Low nibble: 0 for empty or color * 6 + kind + 1, high nibble: state index
         
     public:
 
@@ -61,6 +110,14 @@ class Piece
         */
         Piece(char type = PieceType::EMPTY, char state = PieceState::NORMAL);
 
+        /**
+         * @brief Build a normal piece from its color and kind
+         * @param color: The piece color, check PieceColor for reference
+         * @param kind: The piece kind, check PieceKind for reference
+         * @return The piece
+        */
+        static Piece make(int color, int kind);
+
         /**
          * @brief Capture the piece
         */
@@ -77,30 +134,425 @@ class Piece
         */
         char getState() const;
         /**
-         * @brief Get the unique ID of the piece
-         * @return The piece ID as an integer
+         * @brief Check whether this is the empty piece
+         * @return true if the piece type is PieceType::EMPTY
+        */
+        bool isEmpty() const { return (_code & 0x0F) == 0; }
+        /**
+         * @brief Get the color of a non-empty piece
+         * @return The piece color, check PieceColor for reference
+        */
+        int getColor() const { return ((_code & 0x0F) - 1) / 6; }
+        /**
+         * @brief Get the kind of the piece
+         * @return The piece kind, or PieceKind::NONE if empty. Check PieceKind for reference
         */
-        int getId() const;
+        int getKind() const { return isEmpty() ? PieceKind::NONE : ((_code & 0x0F) - 1) % 6; }
+
+        /**
+         * @brief Get the raw byte of the piece, type and state included
+         * @return The code, see fromCode
+        */
+        uint8_t getCode() const { return _code; }
+        /**
+         * @brief Rebuild a piece from its raw byte
+         * @param code: A code returned by getCode
+         * @return The piece
+        */
+        static Piece fromCode(uint8_t code) { Piece piece; piece._code = code; return piece; }
 };
 
-class Move{
+/**
+ * @brief A move packed in 16 bits
+ * Bits 0-5: from square, bits 6-11: to square, bits 12-13: promotion kind minus
+ * PieceKind::KNIGHT, bits 14-15: Move::Type. Castling is encoded as the king's two-square step.
+ */
+class Move
+{
+    private:
+        uint16_t _data;
+
     public:
-        int toX;
-        int toY;
-        int fromY = -1;
-        int fromX = -1;
-        char pieceType = ' ';
-        bool isCheck = false;
-        bool isMate = false;
-        bool isCapture = false;
-        bool isPromotion = false;
-        char promotionType = ' ';
+        /// @brief Special move flags
+        enum Type {
+            NORMAL = 0,
+            PROMOTION = 1 << 14,
+            EN_PASSANT = 2 << 14,
+            CASTLING = 3 << 14
+        };
+
+        /// @brief Uninitialized move, so move lists cost nothing to construct
+        Move() = default;
+
+        /**
+         * @brief Build a move from its raw 16-bit encoding
+         * @param data The encoded move, check raw()
+        */
+        constexpr explicit Move(uint16_t data) : _data(data) {}
+
+        /**
+         * @brief Build a move
+         * @param from The starting square (0-63)
+         * @param to The target square (0-63)
+         * @param type The special flag, check Move::Type for reference
+         * @param promotionKind The promotion piece kind (KNIGHT to QUEEN), only used by PROMOTION
+        */
+        constexpr Move(int from, int to, Type type = NORMAL, int promotionKind = PieceKind::KNIGHT)
+            : _data(static_cast<uint16_t>(from | (to << 6) | ((promotionKind - PieceKind::KNIGHT) << 12) | type)) {}
+
+        /// @brief The null move, used as "no move"
+        static constexpr Move none() { return Move(static_cast<uint16_t>(0)); }
+
+        /// @brief Get the starting square (0-63)
+        constexpr int from() const { return _data & 0x3F; }
+        /// @brief Get the target square (0-63)
+        constexpr int to() const { return (_data >> 6) & 0x3F; }
+        /// @brief Get the special flag, check Move::Type for reference
+        constexpr Type type() const { return static_cast<Type>(_data & (3 << 14)); }
+        /// @brief Check whether the move is a promotion
+        constexpr bool isPromotion() const { return type() == PROMOTION; }
+        /// @brief Get the promotion piece kind, only meaningful for promotions
+        constexpr int promotionKind() const { return ((_data >> 12) & 3) + PieceKind::KNIGHT; }
+        /// @brief Get the raw 16-bit encoding
+        constexpr uint16_t raw() const { return _data; }
+
+        /// @brief Get the starting file (0 for 'a' ... 7 for 'h')
+        constexpr int fromX() const { return fileOf(from()); }
+        /// @brief Get the starting rank (0-7)
+        constexpr int fromY() const { return rankOf(from()); }
+        /// @brief Get the target file (0 for 'a' ... 7 for 'h')
+        constexpr int toX() const { return fileOf(to()); }
+        /// @brief Get the target rank (0-7)
+        constexpr int toY() const { return rankOf(to()); }
+
+        constexpr bool operator==(const Move& other) const { return _data == other._data; }
+        constexpr bool operator!=(const Move& other) const { return _data != other._data; }
+
+        /**
+         * @brief Convert the move to UCI notation
+         * @return e.g. "e2e4", "e7e8q", or "0000" for the null move
+        */
+        string toUCI() const;
 };
 
+/// @brief Buffer size that fits any FEN written by ChessBoard::writeFEN, terminating null included
+/// 71 placement (64 squares, 7 slashes) + 10 for " w", " KQkq" and " e3"
+/// + 2 x 11 for a space and a counter of up to 10 digits + 1 null = 104
+#define MAX_FEN_LENGTH 104
+
+/// @brief Maximum number of moves in a position. No legal chess position has more than 218;
+///        FENToBoard rejects material that no game can reach, which would break that bound
+#define MAX_MOVES 256
+
+/// @brief Fixed-capacity list of moves, meant to live on the stack (512 bytes of moves)
+class MoveList
+{
+    private:
+        Move _moves[MAX_MOVES];
+        int _size = 0;
+
+    public:
+        /**
+         * @brief Append a move. The list must not be full: debug builds assert, release
+         * builds drop the move rather than write past the list
+         * @param move The move to append
+        */
+        void add(Move move) {
+            assert(_size < MAX_MOVES && "MoveList overflow");
+            if (_size < MAX_MOVES) {
+                _moves[_size++] = move;
+            }
+        }
+
+        /// @brief Remove every move
+        void clear() { _size = 0; }
+
+        /// @brief Get the number of moves
+        int size() const { return _size; }
+
+        /// @brief Get the move at an index (0 to size() - 1)
+        const Move& operator[](int index) const { return _moves[index]; }
+
+        /// @brief Get the move at an index (0 to size() - 1)
+        Move& operator[](int index) { return _moves[index]; }
+
+        /**
+         * @brief Check whether a move is in the list
+         * @param move The move to look for
+         * @return true if found
+        */
+        bool contains(Move move) const {
+            for (int i = 0; i < _size; i++) {
+                if (_moves[i] == move) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Move* begin() { return _moves; }
+        Move* end() { return _moves + _size; }
+        const Move* begin() const { return _moves; }
+        const Move* end() const { return _moves + _size; }
+};
+
+/// @brief  FEN fields, used to report where parsing stopped
+namespace FenField {
+    enum Field {
+        NONE = 0,
+        PLACEMENT = 1,
+        ACTIVE_COLOR = 2,
+        CASTLING = 3,
+        EN_PASSANT = 4,
+        HALFMOVE_CLOCK = 5,
+        FULLMOVE_NUMBER = 6
+    };
+}
+
+/// @brief  Game states, as reported by ChessBoard::gameState
+namespace GameState {
+    enum State {
+        ONGOING = 0,
+        CHECKMATE = 1,
+        STALEMATE = 2,
+        INSUFFICIENT_MATERIAL = 3,
+        FIFTY_MOVE_RULE = 4,
+        REPETITION = 5
+    };
+
+    /**
+     * @brief  Get a readable name of a game state
+     * @param  state: The game state, check GameState for reference
+     * @return The name, e.g. "checkmate"
+     */
+    const char* name(int state);
+}
+
+/// @brief Result of ChessBoard::FENToBoard, empty when the FEN was loaded
+struct FenError
+{
+    /// @brief The field where parsing stopped, check FenField for reference
+    int field = FenField::NONE;
+    /// @brief Character offset of the problem in the FEN
+    size_t offset = 0;
+    /// @brief Static description of the problem, nullptr on success
+    const char* message = nullptr;
+
+    /// @brief Check whether the FEN was loaded
+    bool ok() const { return message == nullptr; }
+};
+
+/// @brief Reason ChessBoard::parseStrMove rejected a move, empty when the move is legal
+struct MoveError
+{
+    /// @brief Static description of the problem, nullptr on success
+    const char* message = nullptr;
+
+    /// @brief Check whether the move was accepted
+    bool ok() const { return message == nullptr; }
+};
+
+/// @brief Statistics reported by ChessBoard::loadFENStream
+struct BulkLoadStats
+{
+    /// @brief Number of positions loaded
+    size_t positions = 0;
+    /// @brief Number of lines that could not be loaded
+    size_t failures = 0;
+    /// @brief Wall-clock time spent loading, in seconds
+    double seconds = 0.0;
+
+    /**
+     * @brief Get the loading throughput
+     * @return Positions loaded per second, 0 if nothing was timed
+    */
+    double positionsPerSecond() const;
+
+    /**
+     * @brief Print the statistics to the console
+    */
+    void print() const;
+};
+
+/// @brief Number of moves kept for ChessBoard::unmakeMove, older moves are forgotten
+#define MAX_UNDO 1024
+
+/// @brief Everything makeMove overwrites and unmakeMove needs back
+struct UndoInfo
+{
+    /// @brief Zobrist key before the move
+    uint64_t key;
+    /// @brief Move count before the move
+    int moveCount;
+    /// @brief Halfmove clock before the move
+    int halfmoveClock;
+    /// @brief The move that was played
+    Move move;
+    /// @brief Code of the captured piece (see Piece::getCode), empty if none. Kept raw so
+    ///        UndoInfo stays trivially default-constructible and UndoStack copies skip the ring
+    uint8_t captured;
+    /// @brief Castling rights before the move, check CastlingRight for reference
+    uint8_t castling;
+    /// @brief En passant target square before the move, or NO_SQUARE
+    int8_t enPassantTarget;
+    /// @brief Checkers before the move
+    Bitboard checkers;
+    /// @brief Pinned pieces before the move
+    Bitboard pinned;
+};
+
+/// @brief Ring buffer of UndoInfo, the oldest entries are dropped once MAX_UNDO moves are stored.
+///        Copies only carry the moves that can still be taken back, not the whole buffer.
+class UndoStack
+{
+    private:
+        UndoInfo _entries[MAX_UNDO]; // Newest entry at _top - 1, wrapping around
+        int _top = 0;                // Next write index into _entries
+        int _size = 0;               // Number of stored entries
+
+    public:
+        UndoStack() = default;
+        UndoStack(const UndoStack& other) noexcept;
+        UndoStack& operator=(const UndoStack& other) noexcept;
+
+        /**
+         * @brief Make room for a new entry, dropping the oldest one when full
+         * @return The new entry, to be filled by the caller
+        */
+        UndoInfo& push();
+
+        /**
+         * @brief Remove the newest entry
+         * @return The removed entry, valid until the next push. The stack must not be empty
+        */
+        const UndoInfo& pop();
+
+        /**
+         * @brief Get a stored entry without removing it
+         * @param ply 0 for the newest entry, 1 for the one before, ... up to size() - 1
+         * @return The entry
+        */
+        const UndoInfo& peek(int ply) const { return _entries[(_top + MAX_UNDO - 1 - ply) % MAX_UNDO]; }
+
+        /// @brief Forget every entry
+        void clear() { _top = 0; _size = 0; }
+
+        /// @brief Get the number of stored entries, at most MAX_UNDO
+        int size() const { return _size; }
+};
+
+struct PackedPosition;
+
 class ChessBoard
 {
     private:
-        Piece*** _board; // 2D array of Piece pointers
+        Piece _squares[SQUARE_NB]; // Piece on every square, indexed by square (a1 = 0, h8 = 63)
+        Bitboard _byKind[6];  // One bitboard per PieceKind, both colors
+        Bitboard _byColor[2]; // One bitboard per PieceColor, all kinds
+        Bitboard _occupied;   // Every occupied square
+        uint64_t _key = 0;    // Zobrist key, updated incrementally
+        int _material[2] = { 0, 0 }; // Material of every color in centipawns, updated incrementally
+        int _phase = 0;         // Sum of the PieceValue::phase weights of every piece
+        Bitboard _checkers = 0; // Enemy pieces giving check to the side to move
+        Bitboard _pinned = 0;   // Pieces of the side to move pinned to their king
+
+        UndoStack _undo;      // Played moves that can still be taken back
+
+        // FEN cache of getFEN: ranks are re-encoded only when a piece on them changed, the
+        // whole string only when a rank or one of the recorded tail fields changed
+        char _fen[MAX_FEN_LENGTH];  // Cached FEN, null-terminated
+        size_t _fenLength = 0;      // Cached FEN length, 0 if never built
+        char _fenRanks[8][8];       // Encoded placement of every rank, indexed by rank
+        uint8_t _fenRankLength[8];  // Length of every encoded rank
+        uint8_t _fenDirtyRanks = 0xFF; // One bit per rank to re-encode
+        char _fenTurn = 0;          // turn when the cache was built
+        uint8_t _fenCastling = 0;   // Castling bits when the cache was built
+        int _fenEnPassant = NO_SQUARE; // enPassantTarget when the cache was built
+        int _fenMoveCount = 0;      // moveCount when the cache was built
+        int _fenHalfmoveClock = 0;  // halfmoveClock when the cache was built
+
+        /**
+         * @brief  Put a piece on an empty square
+         * @param  square: The square index (0-63)
+         * @param  piece: The non-empty piece to place
+         */
+        void _addPiece(int square, Piece piece);
+
+        /**
+         * @brief  Remove whatever piece stands on a square
+         * @param  square: The square index (0-63)
+         */
+        void _removePiece(int square);
+
+        /// @brief  Empty every square and bitboard
+        void _clearBoard();
+
+        /**
+         * @brief  Get every piece, of both colors, attacking a square
+         * @param  square: The square index (0-63)
+         * @param  occupied: The occupancy used to block sliders
+         * @return The attackers bitboard
+         */
+        Bitboard _attackersTo(int square, Bitboard occupied) const;
+
+        /// @brief  Recompute _checkers and _pinned for the side to move
+        void _updateCheckInfo();
+
+        /**
+         * @brief  Build the flagged move a piece makes between two squares
+         * Castling, en passant and promotions are recognized from the piece and the squares,
+         * and only flagged when the board allows them: castling needs the king at home, the
+         * right and its rook with nothing in between, en passant needs the target square and
+         * the enemy pawn beside the mover, promotion needs a pawn reaching its own last rank.
+         * Anything else is a plain move.
+         * @param  from: The starting square, must hold a piece
+         * @param  to: The target square
+         * @param  promotionKind: The promotion piece kind (KNIGHT to QUEEN), only used by promotions
+         * @return The move, not validated
+         */
+        Move _inferMove(int from, int to, int promotionKind) const;
+
+        /// @brief  Pack wck/wcq/bck/bcq into CastlingRight bits
+        uint8_t _castlingBits() const;
+
+        /// @brief  Unpack CastlingRight bits into wck/wcq/bck/bcq
+        void _setCastlingBits(uint8_t bits);
+
+        /**
+         * @brief  Get the Zobrist term of the en passant target
+         * Only hashed when a pawn of the side to move can capture there, so the same
+         * position hashes the same whether it came from a FEN or from makeMove.
+         * @return The en passant key, or 0 if there is no capturable target
+         */
+        uint64_t _enPassantKey() const;
+
+        /**
+         * @brief  Check that a position is one the board can play
+         * Each side needs exactly one king, pawns stay off the first and last rank, extra
+         * pieces must be covered by missing pawns as if promoted, the side not to move may
+         * not be in check, and an en passant target needs the pawn that just moved behind it.
+         * Those limits keep the move generator within MAX_MOVES and never let it capture a king.
+         * Shared by FENToBoard and fromPacked.
+         * @param  squares: The 64 pieces indexed by square (a1 = 0, h8 = 63)
+         * @param  turn: The side to move, WHITE_TURN or BLACK_TURN
+         * @param  enPassantTarget: The en passant target on the rank behind the side that just moved, or NO_SQUARE
+         * @return An empty FenError if the position is playable, otherwise the field at fault (offset 0)
+         */
+        static FenError _checkPosition(const Piece* squares, char turn, int enPassantTarget);
+
+        /**
+         * @brief  Encode the placement of one rank
+         * @param  rank: The rank (0-7)
+         * @param  out: Receives up to 8 characters, not null-terminated
+         * @return The number of characters written
+         */
+        uint8_t _writeFenRank(int rank, char* out) const;
+
+        /**
+         * @brief  Write the fields after the placement, leading space included
+         * @param  out: The write position, moved past the written characters
+         */
+        void _writeFenTail(char*& out) const;
 
     public:
         /// @brief  Current turn: 'w' for white, 'b' for black
@@ -118,19 +570,29 @@ class ChessBoard
         /// @brief Move count
         int moveCount = 0;
 
+        /// @brief Halfmoves since the last capture or pawn move, for the 50-move rule
+        int halfmoveClock = 0;
+
         float eval;
+        /// @brief Whether the side to move is checkmated, updated by getBotMove from gameState
         bool isMate = false;
 
         bool botColor = false; // false for black, true for white
 
-        /// @brief En passant target piece or nullptr if none
-        Piece* enPassantTarget = nullptr;
+        /// @brief En passant target square (0-63) as written in FEN, or NO_SQUARE if none
+        int enPassantTarget = NO_SQUARE;
         
         /** 
          * @brief ChessBoard Constructor
          * @param startingPosition: If true, initializes to standard chess starting position; otherwise, empty board
         */
         ChessBoard(bool startingPosition);
+
+        // Boards are plain values: a copy is an independent snapshot that another thread
+        // can own. Only the moves that can still be taken back are copied with it, so a
+        // fresh position copies a few hundred bytes. Moving is the same as copying.
+        ChessBoard(const ChessBoard& other) = default;
+        ChessBoard& operator=(const ChessBoard& other) = default;
         /** 
          * @brief Reset the chess board
          * @param startingPosition: If true, resets to standard chess starting position; otherwise, empties the board
@@ -143,36 +605,293 @@ class ChessBoard
          * @param rank The y-coordinate (rank)
          * @return Pointer to the Piece at the specified position, or nullptr if empty
         */
-        Piece* getPieceAt(int file, int rank) const;
+        const Piece* getPieceAt(int file, int rank) const;
 
         /**
          * @brief Set a piece at a specific position
          * @param file The x-coordinate (file) e.g., 0 for 'a', 1 for 'b', ..., 7 for 'h'
          * @param rank The y-coordinate (rank)
-         * @param piece Pointer to the Piece to place at the specified position
+         * @param piece The Piece to place at the specified position, an empty Piece clears the square
+        */
+        void setPieceAt(int file, int rank, Piece piece);
+
+        /**
+         * @brief Get the whole mailbox, e.g. to compare two boards
+         * @return The 64 pieces indexed by square (a1 = 0, h8 = 63), valid while the board lives
+        */
+        const Piece* squares() const { return _squares; }
+
+        /**
+         * @brief Get the squares occupied by pieces of one color and kind
+         * @param color The piece color, check PieceColor for reference
+         * @param kind The piece kind, check PieceKind for reference
+         * @return The bitboard of matching pieces
+        */
+        Bitboard pieces(int color, int kind) const { return _byColor[color] & _byKind[kind]; }
+
+        /**
+         * @brief Get the squares occupied by pieces of one kind, both colors
+         * @param kind The piece kind, check PieceKind for reference
+         * @return The bitboard of matching pieces
         */
-        void setPieceAt(int file, int rank, Piece* piece);
+        Bitboard piecesOfKind(int kind) const { return _byKind[kind]; }
+
+        /**
+         * @brief Get the squares occupied by pieces of one color
+         * @param color The piece color, check PieceColor for reference
+         * @return The bitboard of matching pieces
+        */
+        Bitboard piecesOfColor(int color) const { return _byColor[color]; }
+
+        /**
+         * @brief Get every occupied square
+         * @return The occupancy bitboard
+        */
+        Bitboard occupied() const { return _occupied; }
+
+        /**
+         * @brief Get the number of pieces of one color and kind
+         * @param color The piece color, check PieceColor for reference
+         * @param kind The piece kind, check PieceKind for reference
+         * @return The count, a single popcount of the matching bitboard
+        */
+        int pieceCount(int color, int kind) const { return popCount(pieces(color, kind)); }
+
+        /**
+         * @brief List the squares of every piece of one color, pawns first and king last
+         * @param color The piece color, check PieceColor for reference
+         * @param squares Receives the squares
+         * @param capacity The number of entries squares can hold, the list is cut there
+         * @return The number of squares written, at most capacity
+        */
+        int pieceList(int color, int* squares, int capacity) const;
+
+        /**
+         * @brief Get the material of one color, kept up to date by every board change
+         * @param color The piece color, check PieceColor for reference
+         * @return The material in centipawns, see PieceValue
+        */
+        int material(int color) const { return _material[color]; }
+
+        /**
+         * @brief Get the material balance
+         * @return White material minus black material, in centipawns
+        */
+        int materialBalance() const { return _material[PieceColor::WHITE] - _material[PieceColor::BLACK]; }
+
+        /**
+         * @brief Get the game phase from the remaining non-pawn material
+         * @return MAX_PHASE with the starting material down to 0 with bare kings and pawns
+        */
+        int phase() const { return _phase < MAX_PHASE ? _phase : MAX_PHASE; }
 
         /**
          * @brief Move a piece from one position to another
+         * Castling, en passant and promotions are recognized from the squares and played
+         * with makeMove, so the rook, the captured pawn, castling rights, the en passant
+         * target and the clocks all follow. The move itself is not validated: a king step
+         * without the castling right or rook, or a diagonal pawn step that is not en passant,
+         * simply moves the piece. Nothing happens if the starting square is empty.
          * @param fromFile The starting x-coordinate (file)
          * @param fromRank The starting y-coordinate (rank)
          * @param toFile The target x-coordinate (file)
          * @param toRank The target y-coordinate (rank)
+         * @param promotionKind The piece kind a pawn reaching the last rank becomes (KNIGHT to QUEEN)
+        */
+        void movePiece(int fromFile, int fromRank, int toFile, int toRank, int promotionKind = PieceKind::QUEEN);
+
+        /**
+         * @brief Parse and validate a UCI move such as "e2e4" or "e7e8q"
+         * The move is looked up in the legal moves of the position, so a returned move
+         * can always be passed to makeMove. Promotions must name their piece.
+         * @param uci The move in UCI notation, lowercase
+         * @param error Receives the reason the move was rejected, may be nullptr
+         * @return The flagged move, or Move::none() if it is malformed or illegal
         */
-        void movePiece(int fromFile, int fromRank, int toFile, int toRank);
+        Move parseStrMove(string_view uci, MoveError* error = nullptr) const;
+
+        /**
+         * @brief Play a move in place, remembering what is needed to take it back
+         * Handles captures, castling, en passant, promotions, castling rights,
+         * the en passant target and the move counters. The move is expected to come
+         * from generateLegalMoves; it is not validated.
+         * @param move The move to play
+        */
+        void makeMove(Move move);
+
+        /**
+         * @brief Take back the last move played with makeMove
+         * @return false if there is no move left to take back
+        */
+        bool unmakeMove();
+
+        /**
+         * @brief Get the number of moves that unmakeMove can take back
+         * @return The undo stack depth, at most MAX_UNDO
+        */
+        int undoDepth() const { return _undo.size(); }
+
+        /**
+         * @brief Count how often the current position occurred before
+         * Compares Zobrist keys of the undo stack, only within the halfmove clock window
+         * since nothing before the last capture or pawn move can repeat. Positions from
+         * before the last FEN load are unknown.
+         * @return The number of earlier occurrences, 2 or more is a threefold repetition
+        */
+        int repetitionCount() const;
+
+        /**
+         * @brief Check whether neither side can ever mate: bare kings, a single minor
+         * piece, or only bishops that all stand on squares of one color
+         * @return true if the material can never deliver mate
+        */
+        bool isInsufficientMaterial() const;
+
+        /**
+         * @brief Detect the end of the game from the position alone
+         * Checkmate and stalemate come first, then insufficient material, the 50-move
+         * rule and threefold repetition. Generates the legal moves once.
+         * @return The game state, check GameState for reference
+        */
+        int gameState() const;
+
+        /**
+         * @brief Get the Zobrist key of the position
+         * Kept up to date by every board method. Assigning turn, the castling flags or
+         * enPassantTarget directly bypasses it; call FENToBoard or refreshKey afterwards.
+         * @return The 64-bit key
+        */
+        uint64_t getKey() const { return _key; }
+
+        /**
+         * @brief Compute the Zobrist key of the position from scratch
+         * @return The 64-bit key, equal to getKey() when the board is consistent
+        */
+        uint64_t computeKey() const;
+
+        /**
+         * @brief Recompute the stored Zobrist key and check information after editing public fields directly
+        */
+        void refreshKey() { _key = computeKey(); _updateCheckInfo(); }
+
+        /**
+         * @brief Get every piece, of both colors, attacking a square on the current board
+         * @param square The square index (0-63)
+         * @return The attackers bitboard
+        */
+        Bitboard attackersTo(int square) const { return _attackersTo(square, _occupied); }
+
+        /**
+         * @brief Get the enemy pieces giving check to the side to move
+         * Cached per position, kept up to date like the Zobrist key.
+         * @return The checkers bitboard, empty if not in check or without a king
+        */
+        Bitboard checkers() const { return _checkers; }
+
+        /**
+         * @brief Get the pieces of the side to move that are pinned to their king
+         * Cached per position, kept up to date like the Zobrist key.
+         * @return The pinned pieces bitboard
+        */
+        Bitboard pinned() const { return _pinned; }
+
+        /**
+         * @brief Check whether the side to move is in check
+         * @return true if at least one enemy piece attacks the king
+        */
+        bool inCheck() const { return _checkers != 0; }
+
+        /**
+         * @brief Generate every legal move of the side to move
+         * Covers castling (from wck/wcq/bck/bcq), en passant (from enPassantTarget) and promotions.
+         * @param moves The list to fill, cleared first
+        */
+        void generateLegalMoves(MoveList& moves) const;
+
+        /**
+         * @brief Check whether a move captures a piece, en passant included
+         * @param move The move, expected to be legal in this position
+         * @return true if the move captures
+        */
+        bool isCapture(Move move) const {
+            return move.type() == Move::EN_PASSANT || (move.type() != Move::CASTLING && (_occupied & squareBB(move.to())));
+        }
+
+        /**
+         * @brief Static exchange evaluation: the material outcome of the capture sequence
+         * that the move starts on its target square, without playing any move
+         * Both sides recapture with their least valuable attacker and may stop at any
+         * point; sliders hidden behind earlier attackers join in as x-rays. Pins are not
+         * considered and the king only recaptures when the square is no longer defended.
+         * @param move The move, expected to be legal in this position
+         * @return The material won (negative if lost) by the side to move, in centipawns
+        */
+        int see(Move move) const;
 
         /**
          * @brief Convert the current board state to FEN notation
+         * Built from scratch without touching the board, like writeFEN.
          * @return The FEN string representing the current board state
         */
-        string boardToFEN();
+        string boardToFEN() const;
+
+        /**
+         * @brief Get the FEN of the current board state from the board's cache
+         * Piece changes only re-encode the ranks they touch, and reading again before
+         * the next change costs a few compares. Refreshing the cache modifies the board,
+         * so readers sharing a const board use writeFEN or boardToFEN instead.
+         * @return A view of the FEN, valid until the board changes
+        */
+        string_view getFEN();
+
+        /**
+         * @brief Write the current board state as FEN into a caller-provided buffer
+         * Single pass over the board, no cache and no allocation, so any number of
+         * threads may call it on one const board. The result is null-terminated.
+         * @param buffer The buffer to write to
+         * @param size The buffer size, MAX_FEN_LENGTH is always enough
+         * @return The FEN length without the terminating null, or 0 if the buffer is too small
+        */
+        size_t writeFEN(char* buffer, size_t size) const;
 
         /**
          * @brief Set up the board from a FEN string
+         * Single pass, no allocation and no exceptions. The halfmove clock and fullmove
+         * number may be omitted (EPD style). The position must be playable: one king per
+         * side, no pawns on the back ranks, no more pieces than promotions allow, the side
+         * not to move not in check and an en passant target behind a pawn that just moved.
+         * On error the board is left unchanged.
          * @param fen The FEN string to parse and set up the board
+         * @return An empty FenError on success, otherwise the failing field and offset
+         */
+        FenError FENToBoard(string_view fen);
+
+        /**
+         * @brief Encode the position into the 32-byte binary format, see PackedPosition
+         * @param packed Receives the encoding
+         * @return false if the board holds more than 32 pieces, packed is then left unchanged
+         */
+        bool toPacked(PackedPosition& packed) const;
+
+        /**
+         * @brief Set up the board from the 32-byte binary format, see PackedPosition
+         * The position must pass the same checks as FENToBoard and the move count must be
+         * at least 1, so blobs from files or other processes are as safe as FENs.
+         * @param packed The encoding to load
+         * @return false if the encoding is invalid, the board is then left unchanged
+         */
+        bool fromPacked(const PackedPosition& packed);
+
+        /**
+         * @brief Load every FEN of a stream, one per line, into this board
+         * The board is reused in place for every line, so streaming a whole dataset
+         * through it never touches the allocator once the line buffer has grown.
+         * Empty lines are skipped, invalid FENs are counted as failures.
+         * @param in The stream to read FEN lines from
+         * @param onPosition Called with the board after every loaded position, may be empty
+         * @return The load statistics, including positions per second
          */
-        void FENToBoard(const string& fen);
+        BulkLoadStats loadFENStream(istream& in, const function<void(const ChessBoard&)>& onPosition = nullptr);
         
         /**
          * @brief Print the current board state to the console
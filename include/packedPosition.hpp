@@ -0,0 +1,41 @@
+#ifndef PACKED_POSITION_HPP
+#define PACKED_POSITION_HPP
+
+#include <chess.hpp>
+
+#include <functional>
+
+/// @brief  Canonical 32-byte binary position, for caches, datasets and IPC.
+///         Equal positions always encode to equal bytes: the en passant target is only
+///         kept when a pawn of the side to move can capture there. Words are stored in
+///         host byte order.
+struct PackedPosition
+{
+    /// @brief Every occupied square
+    Bitboard occupied = 0;
+    /// @brief Piece codes (color * 6 + kind + 1) of the occupied squares from a1 to h8,
+    ///        two per byte with the lower square in the low nibble, unused nibbles are 0
+    uint8_t pieces[16] = {};
+    /// @brief Bit 0: black to move, bits 1-4: CastlingRight bits, bit 5: en passant,
+    ///        bits 6-8: en passant file, bits 9-22: halfmove clock, bits 23-39: move count
+    uint64_t state = 0;
+
+    /**
+     * @brief Hash the encoding directly, without decoding it
+     * @return A 64-bit hash of the 32 bytes
+     */
+    uint64_t hash() const;
+
+    bool operator==(const PackedPosition& other) const;
+    bool operator!=(const PackedPosition& other) const { return !(*this == other); }
+};
+
+namespace std {
+    /// @brief  Lets PackedPosition key unordered containers
+    template <>
+    struct hash<PackedPosition> {
+        size_t operator()(const PackedPosition& packed) const { return static_cast<size_t>(packed.hash()); }
+    };
+}
+
+#endif // PACKED_POSITION_HPP
@@ -0,0 +1,57 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <bitboard.hpp>
+
+/// @brief  Zobrist hashing keys, generated at compile time
+namespace Zobrist {
+    /// @brief  Every random key used to hash a position
+    struct Keys {
+        /// @brief  Piece keys indexed by [color * 6 + kind][square]
+        uint64_t piece[12][SQUARE_NB];
+        /// @brief  Castling keys indexed by CastlingRight bits
+        uint64_t castling[16];
+        /// @brief  En passant keys indexed by the target file
+        uint64_t enPassant[8];
+        /// @brief  Toggled when black is to move
+        uint64_t blackToMove;
+    };
+
+    /**
+     * @brief  SplitMix64 step, a small generator that is easy to evaluate at compile time
+     * @param  state: The generator state, advanced by one step
+     * @return The next random value
+     */
+    constexpr uint64_t splitMix64(uint64_t& state) {
+        state += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// @brief  Build every key from a fixed seed
+    constexpr Keys makeKeys() {
+        Keys keys = {};
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (int piece = 0; piece < 12; piece++) {
+            for (int square = 0; square < SQUARE_NB; square++) {
+                keys.piece[piece][square] = splitMix64(state);
+            }
+        }
+        // No rights hashes to 0 so that a bare position needs no castling term
+        for (int rights = 1; rights < 16; rights++) {
+            keys.castling[rights] = splitMix64(state);
+        }
+        for (int file = 0; file < 8; file++) {
+            keys.enPassant[file] = splitMix64(state);
+        }
+        keys.blackToMove = splitMix64(state);
+        return keys;
+    }
+
+    /// @brief  The keys, stored in read-only data
+    inline constexpr Keys keys = makeKeys();
+}
+
+#endif // ZOBRIST_HPP
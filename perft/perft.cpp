@@ -0,0 +1,630 @@
+#include <chess.hpp>
+#include <boardDiff.hpp>
+#include <packedPosition.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+#define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+/**
+ * @brief Lock-free perft cache shared by every thread
+ * Each entry stores its data next to key ^ data (lockless hashing): a torn write
+ * from two threads racing on one slot fails the check and reads as a miss.
+ */
+class PerftTable
+{
+    private:
+        struct Entry {
+            atomic<uint64_t> check; // Zobrist key ^ data
+            atomic<uint64_t> data;  // Node count << 8 | depth
+        };
+
+        unique_ptr<Entry[]> _entries;
+        uint64_t _mask = 0;
+
+        /// @brief Get the slot of a position at a depth
+        Entry& _slot(uint64_t key, int depth) const {
+            return _entries[(key ^ (static_cast<uint64_t>(depth) * 0x9E3779B97F4A7C15ULL)) & _mask];
+        }
+
+    public:
+        /**
+         * @brief PerftTable Constructor
+         * @param megabytes The table size, rounded down to a power of two entries. 0 disables the table.
+        */
+        explicit PerftTable(size_t megabytes) {
+            size_t count = (megabytes << 20) / sizeof(Entry);
+            if (count == 0) {
+                return;
+            }
+            size_t size = 1;
+            while (size * 2 <= count) {
+                size *= 2;
+            }
+            _entries.reset(new Entry[size]);
+            _mask = size - 1;
+            clear();
+        }
+
+        /// @brief Check whether the table has any entry
+        bool enabled() const { return _entries != nullptr; }
+
+        /// @brief Empty every entry, not thread-safe
+        void clear() {
+            for (uint64_t i = 0; enabled() && i <= _mask; i++) {
+                _entries[i].check.store(0, memory_order_relaxed);
+                _entries[i].data.store(0, memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Look a position up
+         * @param key The Zobrist key of the position
+         * @param depth The remaining depth
+         * @param nodes Set to the stored node count on a hit
+         * @return true on a hit
+        */
+        bool probe(uint64_t key, int depth, uint64_t* nodes) const {
+            Entry& entry = _slot(key, depth);
+            uint64_t data = entry.data.load(memory_order_relaxed);
+            uint64_t check = entry.check.load(memory_order_relaxed);
+            if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth) {
+                return false;
+            }
+            *nodes = data >> 8;
+            return true;
+        }
+
+        /**
+         * @brief Store a node count, always replacing the slot
+         * @param key The Zobrist key of the position
+         * @param depth The remaining depth
+         * @param nodes The node count
+        */
+        void store(uint64_t key, int depth, uint64_t nodes) {
+            Entry& entry = _slot(key, depth);
+            uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth);
+            entry.check.store(key ^ data, memory_order_relaxed);
+            entry.data.store(data, memory_order_relaxed);
+        }
+};
+
+/**
+ * @brief  Count the leaf nodes of the move tree
+ * @param  board: The position, walked in place with makeMove/unmakeMove
+ * @param  depth: The remaining depth, at least 1
+ * @param  table: The shared cache, or nullptr
+ * @return The number of leaf nodes
+ */
+static uint64_t perft(ChessBoard& board, int depth, PerftTable* table) {
+    MoveList moves;
+    board.generateLegalMoves(moves);
+
+    // Bulk counting: the last ply only needs the number of legal moves
+    if (depth == 1) {
+        return static_cast<uint64_t>(moves.size());
+    }
+
+    uint64_t nodes = 0;
+    if (table != nullptr && table->probe(board.getKey(), depth, &nodes)) {
+        return nodes;
+    }
+
+    for (Move move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1, table);
+        board.unmakeMove();
+    }
+
+    if (table != nullptr) {
+        table->store(board.getKey(), depth, nodes);
+    }
+    return nodes;
+}
+
+/**
+ * @brief  Count the leaf nodes below every root move, spread over threads
+ * Work is split two plies deep when possible, so a handful of heavy root moves
+ * do not leave the other threads idle.
+ * @param  root: The position
+ * @param  depth: The depth, at least 1
+ * @param  threads: The number of worker threads, at least 1
+ * @param  table: The shared cache, or nullptr
+ * @param  rootMoves: Filled with the root moves
+ * @return The node count of every root move, in the order of rootMoves
+ */
+static vector<uint64_t> parallelPerft(const ChessBoard& root, int depth, int threads, PerftTable* table, MoveList& rootMoves) {
+    root.generateLegalMoves(rootMoves);
+    vector<uint64_t> counts(rootMoves.size(), depth == 1 ? 1 : 0);
+    if (depth == 1) {
+        return counts;
+    }
+
+    // A task is a root move index and an optional reply
+    struct Task {
+        int rootIndex;
+        Move reply;
+    };
+    vector<Task> tasks;
+    ChessBoard board = root;
+    for (int i = 0; i < rootMoves.size(); i++) {
+        if (depth < 3) {
+            tasks.push_back({ i, Move::none() });
+            continue;
+        }
+        MoveList replies;
+        board.makeMove(rootMoves[i]);
+        board.generateLegalMoves(replies);
+        board.unmakeMove();
+        for (Move reply : replies) {
+            tasks.push_back({ i, reply });
+        }
+    }
+
+    unique_ptr<atomic<uint64_t>[]> results(new atomic<uint64_t>[counts.size()]);
+    for (size_t i = 0; i < counts.size(); i++) {
+        results[i].store(0);
+    }
+    atomic<size_t> nextTask(0);
+
+    auto worker = [&]() {
+        ChessBoard local = root;
+        size_t index;
+        while ((index = nextTask.fetch_add(1)) < tasks.size()) {
+            const Task& task = tasks[index];
+            uint64_t nodes;
+            local.makeMove(rootMoves[task.rootIndex]);
+            if (task.reply == Move::none()) {
+                nodes = perft(local, depth - 1, table);
+            } else {
+                local.makeMove(task.reply);
+                nodes = perft(local, depth - 2, table);
+                local.unmakeMove();
+            }
+            local.unmakeMove();
+            results[task.rootIndex].fetch_add(nodes);
+        }
+    };
+
+    vector<thread> pool;
+    for (int i = 1; i < threads; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : pool) {
+        t.join();
+    }
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = results[i].load();
+    }
+    return counts;
+}
+
+/**
+ * @brief  Count the nodes of a position, spread over threads
+ * @param  board: The position
+ * @param  depth: The depth, at least 1
+ * @param  threads: The number of worker threads, at least 1
+ * @param  table: The shared cache, or nullptr
+ * @param  showDivide: Whether to print the node count of every root move
+ * @return The total number of leaf nodes
+ */
+static uint64_t countNodes(const ChessBoard& board, int depth, int threads, PerftTable* table, bool showDivide) {
+    MoveList rootMoves;
+    vector<uint64_t> counts = parallelPerft(board, depth, threads, table, rootMoves);
+
+    uint64_t total = 0;
+    for (int i = 0; i < rootMoves.size(); i++) {
+        if (showDivide) {
+            cout << rootMoves[i].toUCI() << ": " << counts[i] << endl;
+        }
+        total += counts[i];
+    }
+    return total;
+}
+
+/**
+ * @brief  Print a node count with its timing
+ * @param  nodes: The number of nodes
+ * @param  seconds: The elapsed time
+ */
+static void printNodes(uint64_t nodes, double seconds) {
+    cout << "Nodes: " << nodes << "  Time: " << seconds << " s  NPS: "
+         << static_cast<uint64_t>(seconds > 0.0 ? nodes / seconds : 0.0) << endl;
+}
+
+/**
+ * @brief  Time the same perft with 1, 2, 4 ... threads and print the scaling efficiency
+ * The cache is cleared before every run so each thread count starts cold.
+ * @param  board: The position
+ * @param  depth: The depth, at least 1
+ * @param  maxThreads: The largest thread count to try
+ * @param  table: The shared cache, or nullptr
+ */
+static void runScaling(const ChessBoard& board, int depth, int maxThreads, PerftTable* table) {
+    double baseSeconds = 0.0;
+    for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+        if (table != nullptr) {
+            table->clear();
+        }
+        auto start = chrono::steady_clock::now();
+        uint64_t nodes = countNodes(board, depth, threads, table, false);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1) {
+            baseSeconds = seconds;
+        }
+
+        double speedup = (seconds > 0.0) ? baseSeconds / seconds : 0.0;
+        cout << "Threads: " << threads << "  Speedup: " << speedup
+             << "  Efficiency: " << static_cast<int>(100.0 * speedup / threads) << "%  ";
+        printNodes(nodes, seconds);
+
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief  Run every position of an EPD perft suite against its expected counts
+ * Each line holds a FEN followed by ";D<depth> <nodes>" fields.
+ * @param  path: The EPD file
+ * @param  maxDepth: Depths above this are skipped
+ * @param  threads: The number of worker threads, at least 1
+ * @param  table: The shared cache, or nullptr
+ * @return true if every count matched
+ */
+static bool runSuite(const string& path, int maxDepth, int threads, PerftTable* table) {
+    ifstream file(path);
+    if (!file) {
+        cout << "Cannot open " << path << endl;
+        return false;
+    }
+
+    ChessBoard board(false);
+    uint64_t totalNodes = 0;
+    int failures = 0;
+    int checks = 0;
+    auto start = chrono::steady_clock::now();
+
+    string line;
+    while (getline(file, line)) {
+        size_t separator = line.find(';');
+        if (line.empty() || separator == string::npos) {
+            continue;
+        }
+
+        string fen = line.substr(0, separator);
+        while (!fen.empty() && fen.back() == ' ') {
+            fen.pop_back();
+        }
+        cout << fen << endl;
+        FenError error = board.FENToBoard(fen);
+        if (!error.ok()) {
+            cout << "  Invalid FEN at offset " << error.offset << ": " << error.message << endl;
+            failures++;
+            continue;
+        }
+
+        istringstream fields(line.substr(separator));
+        string field;
+        while (getline(fields, field, ';')) {
+            int depth;
+            unsigned long long expected;
+            if (sscanf(field.c_str(), " D%d %llu", &depth, &expected) != 2 || depth > maxDepth) {
+                continue;
+            }
+
+            uint64_t nodes = countNodes(board, depth, threads, table, false);
+            totalNodes += nodes;
+            checks++;
+            bool ok = (nodes == expected);
+            failures += ok ? 0 : 1;
+            cout << "  D" << depth << " " << nodes << (ok ? "  ok" : "  FAILED, expected " + to_string(expected)) << endl;
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << checks - failures << "/" << checks << " counts matched" << endl;
+    printNodes(totalNodes, seconds);
+    return failures == 0;
+}
+
+/**
+ * @brief  Print the outcome of one self-test check
+ * @param  ok: Whether the check passed
+ * @param  name: What was checked
+ * @param  failures: Incremented when the check failed
+ */
+static void report(bool ok, const string& name, int& failures) {
+    cout << "  " << name << (ok ? "  ok" : "  FAILED") << endl;
+    failures += ok ? 0 : 1;
+}
+
+/**
+ * @brief  Load a FEN and play a list of UCI moves on it
+ * @param  board: The board to set up
+ * @param  fen: The starting position
+ * @param  moves: Space-separated UCI moves, may be empty
+ * @return false if the FEN or one of the moves was rejected
+ */
+static bool setUp(ChessBoard& board, const char* fen, const char* moves) {
+    if (!board.FENToBoard(fen).ok()) {
+        return false;
+    }
+    istringstream in(moves);
+    string uci;
+    while (in >> uci) {
+        Move move = board.parseStrMove(uci);
+        if (move == Move::none()) {
+            return false;
+        }
+        board.makeMove(move);
+    }
+    return true;
+}
+
+/**
+ * @brief  Round-trip every position of a small move tree through PackedPosition
+ * @param  board: The position, walked in place with makeMove/unmakeMove
+ * @param  depth: The remaining depth
+ * @return The number of positions that did not come back identical
+ */
+static int packedWalk(ChessBoard& board, int depth) {
+    PackedPosition packed;
+    PackedPosition repacked;
+    ChessBoard copy(false);
+    int mismatches = 0;
+    if (!board.toPacked(packed) || !copy.fromPacked(packed) || copy.getKey() != board.getKey()
+        || !copy.toPacked(repacked) || repacked != packed) {
+        mismatches++;
+    }
+    if (depth == 0) {
+        return mismatches;
+    }
+
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    for (Move move : moves) {
+        board.makeMove(move);
+        mismatches += packedWalk(board, depth - 1);
+        board.unmakeMove();
+    }
+    return mismatches;
+}
+
+/**
+ * @brief  Check the board core beyond move generation against known results:
+ *         static exchange evaluation, game states, FEN rejections, UCI move
+ *         parsing, board diffs and packed positions
+ * @return true if every check passed
+ */
+static bool runSelfTest() {
+    ChessBoard board(false);
+    int failures = 0;
+    int checks = 0;
+
+    cout << "Static exchange evaluation" << endl;
+    const struct { const char* fen; const char* move; int expected; } seeCases[] = {
+        { "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100 },
+        { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -220 },
+        { "4k3/8/3p4/4p3/8/8/8/4QK2 w - - 0 1", "e1e5", -800 },
+        { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100 },
+        { "4k3/8/8/8/8/8/8/R3K3 w - - 0 1", "a1a8", 0 },
+    };
+    for (const auto& c : seeCases) {
+        Move move = Move::none();
+        bool loaded = board.FENToBoard(c.fen).ok() && (move = board.parseStrMove(c.move)) != Move::none();
+        int value = loaded ? board.see(move) : 0;
+        report(loaded && value == c.expected, string(c.move) + " = " + to_string(c.expected) + " in " + c.fen, failures);
+        checks++;
+    }
+
+    cout << "Game states" << endl;
+    const struct { const char* fen; const char* moves; int expected; } stateCases[] = {
+        { STARTING_FEN, "", GameState::ONGOING },
+        { STARTING_FEN, "f2f3 e7e5 g2g4 d8h4", GameState::CHECKMATE },
+        { "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", "", GameState::STALEMATE },
+        { "8/8/4k3/8/8/3BK3/8/8 w - - 0 1", "", GameState::INSUFFICIENT_MATERIAL },
+        { "4k3/8/8/8/8/8/R7/4K3 w - - 100 80", "", GameState::FIFTY_MOVE_RULE },
+        { STARTING_FEN, "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8", GameState::REPETITION },
+        { STARTING_FEN, "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1", GameState::ONGOING },
+    };
+    for (const auto& c : stateCases) {
+        bool loaded = setUp(board, c.fen, c.moves);
+        int state = loaded ? board.gameState() : -1;
+        report(loaded && state == c.expected, string(GameState::name(c.expected)) + " after \"" + c.moves + "\" from " + c.fen, failures);
+        checks++;
+    }
+
+    cout << "Rejected FENs" << endl;
+    const struct { const char* fen; int field; } fenCases[] = {
+        { "QQQQQQQk/Q6Q/Q6Q/Q6Q/Q2Q3Q/Q6Q/Q3QP1Q/KQQ2QQQ w - - 0 1", FenField::PLACEMENT },
+        { "Pnbqkbnr/pppppppp/8/8/8/8/1PPPPPPP/RNBQKBNR w KQkq - 0 1", FenField::PLACEMENT },
+        { "rnbqkbnr/pppppppp/44/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", FenField::PLACEMENT },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQ1BNR w kq - 0 1", FenField::PLACEMENT },
+        { "4k3/8/8/8/8/8/8/K3R3 w - - 0 1", FenField::ACTIVE_COLOR },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", FenField::ACTIVE_COLOR },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkk - 0 1", FenField::CASTLING },
+        { "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e6 0 1", FenField::EN_PASSANT },
+        { "4k3/8/8/8/8/8/8/4K3 w - e6 0 1", FenField::EN_PASSANT },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -0 1", FenField::EN_PASSANT },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - x 1", FenField::HALFMOVE_CLOCK },
+        { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 0", FenField::FULLMOVE_NUMBER },
+    };
+    for (const auto& c : fenCases) {
+        FenError error = board.FENToBoard(c.fen);
+        report(!error.ok() && error.field == c.field, string(c.fen) + (error.ok() ? "" : string(" -> ") + error.message), failures);
+        checks++;
+    }
+
+    cout << "UCI moves" << endl;
+    const struct { const char* fen; const char* move; bool legal; } uciCases[] = {
+        { STARTING_FEN, "e2e4", true },
+        { STARTING_FEN, "g1f3", true },
+        { STARTING_FEN, "e2e5", false },
+        { STARTING_FEN, "a2a1", false },
+        { STARTING_FEN, "e7e5", false },
+        { STARTING_FEN, "e2e4q", false },
+        { STARTING_FEN, "e2", false },
+        { "4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8", false },
+        { "4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8n", true },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1c1", true },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w - - 0 1", "e1g1", false },
+    };
+    for (const auto& c : uciCases) {
+        MoveError error;
+        bool loaded = board.FENToBoard(c.fen).ok();
+        Move move = loaded ? board.parseStrMove(c.move, &error) : Move::none();
+        report(loaded && (move != Move::none()) == c.legal && error.ok() == c.legal,
+               string(c.move) + (c.legal ? " accepted" : " rejected") + (error.ok() ? "" : string(" (") + error.message + ")"), failures);
+        checks++;
+    }
+
+    cout << "Board diff" << endl;
+    const struct { const char* fen; const char* move; } diffCases[] = {
+        { STARTING_FEN, "e2e4" },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1g1" },
+        { "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1", "e8c8" },
+        { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6" },
+        { "1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8r" },
+    };
+    for (const auto& c : diffCases) {
+        ChessBoard after(false);
+        bool loaded = setUp(board, c.fen, "") && setUp(after, c.fen, c.move);
+        report(loaded && BoardDiff::inferMove(board, after).toUCI() == c.move, string(c.move) + " inferred from " + c.fen, failures);
+        checks++;
+    }
+    ChessBoard unrelated(false);
+    setUp(board, STARTING_FEN, "");
+    setUp(unrelated, STARTING_FEN, "e2e4 e7e5");
+    report(BoardDiff::inferMove(board, unrelated) == Move::none(), "two moves apart infer no move", failures);
+    checks++;
+
+    cout << "Packed positions" << endl;
+    const char* packedFens[] = {
+        STARTING_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3",
+    };
+    for (const char* fen : packedFens) {
+        bool loaded = board.FENToBoard(fen).ok();
+        report(loaded && packedWalk(board, 2) == 0, string("round trip to depth 2 from ") + fen, failures);
+        checks++;
+    }
+    PackedPosition packed;
+    report(!board.fromPacked(packed), "empty encoding rejected", failures);
+    checks++;
+    board.FENToBoard(STARTING_FEN);
+    board.toPacked(packed);
+    packed.state &= ~(uint64_t(0x1FFFF) << 23);
+    report(!board.fromPacked(packed), "move count 0 rejected", failures);
+    checks++;
+
+    cout << checks - failures << "/" << checks << " checks passed" << endl;
+    return failures == 0;
+}
+
+static void printUsage() {
+    cout << "Usage:" << endl
+         << "  perft [options] <depth> [fen]     Count nodes (starting position by default)" << endl
+         << "  perft [options] --suite <file.epd> [maxDepth]" << endl
+         << "  perft --selftest                  Check SEE, game states, FEN errors, UCI moves, board diff and packed positions" << endl
+         << "Options:" << endl
+         << "  --divide                          Print the node count of every root move" << endl
+         << "  --path magic|pext                 Force the slider lookup path" << endl
+         << "  --threads <n>                     Worker threads (default 1)" << endl
+         << "  --hash <MB>                       Shared perft cache size (default 0, disabled)" << endl
+         << "  --scaling                         Time 1, 2, 4 ... up to --threads threads" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool showDivide = false;
+    bool showScaling = false;
+    int threads = 1;
+    size_t hashMegabytes = 0;
+    int arg = 1;
+
+    for (; arg < argc && string(argv[arg]).rfind("--", 0) == 0 && string(argv[arg]) != "--suite" && string(argv[arg]) != "--selftest"; arg++) {
+        string option = argv[arg];
+        if (option == "--divide") {
+            showDivide = true;
+        } else if (option == "--scaling") {
+            showScaling = true;
+        } else if (option == "--threads" && arg + 1 < argc) {
+            threads = max(1, atoi(argv[++arg]));
+        } else if (option == "--hash" && arg + 1 < argc) {
+            hashMegabytes = static_cast<size_t>(max(0, atoi(argv[++arg])));
+        } else if (option == "--path" && arg + 1 < argc) {
+            string path = argv[++arg];
+            if (!Attacks::setSliderPath(path == "pext" ? Attacks::PEXT : Attacks::MAGIC)) {
+                cout << "The " << path << " path is not available on this CPU" << endl;
+                return 1;
+            }
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (!Attacks::selfCheck()) {
+        cout << "Slider attack self-check FAILED" << endl;
+        return 1;
+    }
+    cout << "Slider path: " << (Attacks::sliderPath() == Attacks::PEXT ? "pext" : "magic")
+         << "  Threads: " << threads << "  Hash: " << hashMegabytes << " MB" << endl;
+
+    if (arg < argc && string(argv[arg]) == "--selftest") {
+        return runSelfTest() ? 0 : 1;
+    }
+
+    PerftTable table(hashMegabytes);
+    PerftTable* tablePtr = table.enabled() ? &table : nullptr;
+
+    if (arg < argc && string(argv[arg]) == "--suite") {
+        if (arg + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        int maxDepth = (arg + 2 < argc) ? atoi(argv[arg + 2]) : 99;
+        return runSuite(argv[arg + 1], maxDepth, threads, tablePtr) ? 0 : 1;
+    }
+
+    if (arg >= argc || atoi(argv[arg]) < 1) {
+        printUsage();
+        return 1;
+    }
+    int depth = atoi(argv[arg]);
+
+    // The FEN may be passed as one argument or as its space-separated fields
+    string fen;
+    for (int i = arg + 1; i < argc; i++) {
+        fen += (fen.empty() ? "" : " ") + string(argv[i]);
+    }
+    ChessBoard board(false);
+    FenError error = board.FENToBoard(fen.empty() ? STARTING_FEN : fen);
+    if (!error.ok()) {
+        cout << "Invalid FEN at offset " << error.offset << ": " << error.message << endl;
+        return 1;
+    }
+
+    if (showScaling) {
+        runScaling(board, depth, threads, tablePtr);
+        return 0;
+    }
+
+    auto start = chrono::steady_clock::now();
+    uint64_t nodes = countNodes(board, depth, threads, tablePtr, showDivide);
+    printNodes(nodes, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <bitboard.hpp>
+#include <string_view>
+
+#if defined(HAS_PEXT_PATH) && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+using namespace std;
+
+namespace Attacks {
+    atomic<bool> usePext(false);
+    Magic bishopMagics[SQUARE_NB];
+    Magic rookMagics[SQUARE_NB];
+}
+
+/// @brief  Bishop attack table shared by all squares (sum of 2^relevant bits)
+static Bitboard _bishopTable[0x1480];
+/// @brief  Rook attack table shared by all squares (sum of 2^relevant bits)
+static Bitboard _rookTable[0x19000];
+/// @brief  Same as _bishopTable but PEXT-indexed, only filled on CPUs with PEXT
+static Bitboard _bishopPextTable[0x1480];
+/// @brief  Same as _rookTable but PEXT-indexed, only filled on CPUs with PEXT
+static Bitboard _rookPextTable[0x19000];
+
+/// @brief  Whether the PEXT tables were filled
+static bool _pextReady = false;
+
+/// @brief  Bishop magic multipliers, found offline for the shift 64 - popCount(mask)
+static const Bitboard _bishopMagicNumbers[SQUARE_NB] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL
+};
+
+/// @brief  Rook magic multipliers, found offline for the shift 64 - popCount(mask)
+static const Bitboard _rookMagicNumbers[SQUARE_NB] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+/// @brief  Reference ray walk of one slider kind, see AttackGen::rayAttacks
+typedef Bitboard (*SliderRays)(int square, Bitboard occupied);
+
+/**
+ * @brief  Fill the magic entries and attack tables of one slider kind
+ * @param  magics: The magic entries to fill
+ * @param  table: The magic-indexed attack table shared by all squares
+ * @param  pextTable: The PEXT-indexed attack table shared by all squares
+ * @param  numbers: The magic multipliers
+ * @param  rays: The reference ray walk of the slider
+ * @param  fillPext: Whether to fill pextTable, the CPU must support PEXT
+ */
+static void _initMagics(Attacks::Magic magics[SQUARE_NB], Bitboard* table, Bitboard* pextTable, const Bitboard numbers[SQUARE_NB], SliderRays rays, bool fillPext) {
+    Bitboard* next = table;
+    Bitboard* nextPext = pextTable;
+    for (int square = 0; square < SQUARE_NB; square++) {
+        // Edge squares never block anything further, so they are not relevant
+        Bitboard edges = ((0x00000000000000FFULL | 0xFF00000000000000ULL) & ~(0x00000000000000FFULL << (8 * rankOf(square))))
+                       | ((0x0101010101010101ULL | 0x8080808080808080ULL) & ~(0x0101010101010101ULL << fileOf(square)));
+
+        Attacks::Magic& m = magics[square];
+        m.mask = rays(square, 0) & ~edges;
+        m.magic = numbers[square];
+        m.shift = static_cast<unsigned>(64 - popCount(m.mask));
+        m.attacks = next;
+        m.pextAttacks = nextPext;
+
+        // Enumerate every subset of the mask (Carry-Rippler trick)
+        Bitboard subset = 0;
+        do {
+            Bitboard attacks = rays(square, subset);
+            m.attacks[m.index(subset)] = attacks;
+            if (fillPext) {
+                m.pextAttacks[pext(subset, m.mask)] = attacks;
+            }
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+        next += Bitboard(1) << popCount(m.mask);
+        nextPext += Bitboard(1) << popCount(m.mask);
+    }
+}
+
+/**
+ * @brief  Fill the slider tables, the other tables are built at compile time
+ */
+static void _initAttacks() {
+    _pextReady = Attacks::cpuHasFastPext();
+    _initMagics(Attacks::bishopMagics, _bishopTable, _bishopPextTable, _bishopMagicNumbers, AttackGen::bishopRays, _pextReady);
+    _initMagics(Attacks::rookMagics, _rookTable, _rookPextTable, _rookMagicNumbers, AttackGen::rookRays, _pextReady);
+}
+
+/**
+ * @brief  Compare every table entry of one slider kind
+ * @param  magics: The magic entries to check
+ * @param  rays: The reference ray walk of the slider
+ * @return true if every available path matches the ray walk
+ */
+static bool _checkMagics(const Attacks::Magic magics[SQUARE_NB], SliderRays rays) {
+    for (int square = 0; square < SQUARE_NB; square++) {
+        const Attacks::Magic& m = magics[square];
+        Bitboard subset = 0;
+        do {
+            // Bits outside the mask must not change the result either
+            Bitboard occupied = subset | ~(m.mask | squareBB(square));
+            Bitboard expected = rays(square, occupied);
+            if (m.lookup(occupied, false) != expected) {
+                return false;
+            }
+            if (_pextReady && m.lookup(occupied, true) != expected) {
+                return false;
+            }
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+    }
+    return true;
+}
+
+bool Attacks::cpuHasFastPext() {
+#if defined(HAS_PEXT_PATH)
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+    char vendor[13] = { 0 };
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = static_cast<unsigned int>(info[i]);
+    }
+#else
+    __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    unsigned int maxLeaf = regs[0];
+    for (int i = 0; i < 4; i++) {
+        vendor[i] = static_cast<char>(regs[1] >> (8 * i));
+        vendor[i + 4] = static_cast<char>(regs[3] >> (8 * i));
+        vendor[i + 8] = static_cast<char>(regs[2] >> (8 * i));
+    }
+    if (maxLeaf < 7) {
+        return false;
+    }
+
+    // Leaf 7, EBX bit 8: BMI2
+#if defined(_MSC_VER)
+    __cpuidex(info, 7, 0);
+    regs[1] = static_cast<unsigned int>(info[1]);
+#else
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if (!(regs[1] & (1u << 8))) {
+        return false;
+    }
+
+    // AMD implements PEXT in microcode before Zen 3 (family 0x19), slower than a multiply
+    if (string_view(vendor) == "AuthenticAMD") {
+#if defined(_MSC_VER)
+        __cpuid(info, 1);
+        regs[0] = static_cast<unsigned int>(info[0]);
+#else
+        __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        unsigned int family = ((regs[0] >> 8) & 0xF) + ((regs[0] >> 20) & 0xFF);
+        if (family < 0x19) {
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Attacks::init() {
+    // A function-local static runs exactly once, on the first call from any translation
+    // unit or thread, so the tables never depend on the static initialization order
+    static const bool ready = [] {
+        _initAttacks();
+        if (_pextReady && !(_checkMagics(bishopMagics, AttackGen::bishopRays) && _checkMagics(rookMagics, AttackGen::rookRays))) {
+            _pextReady = false;
+        }
+        usePext.store(_pextReady, memory_order_relaxed);
+        return true;
+    }();
+    (void)ready;
+}
+
+Attacks::SliderPath Attacks::sliderPath() {
+    init();
+    return usePext.load(memory_order_relaxed) ? PEXT : MAGIC;
+}
+
+bool Attacks::setSliderPath(SliderPath path) {
+    init();
+    if (path == PEXT && !_pextReady) {
+        return false;
+    }
+    usePext.store(path == PEXT, memory_order_relaxed);
+    return true;
+}
+
+static_assert(atomic<bool>::is_always_lock_free, "Slider lookups must not take a lock");
+
+bool Attacks::selfCheck() {
+    init();
+    return _checkMagics(bishopMagics, AttackGen::bishopRays) && _checkMagics(rookMagics, AttackGen::rookRays);
+}
+
+/// @brief  Also fills the tables during static initialization, so that lookups made
+///         without any board, after main() starts, find them ready
+static struct AttackTablesInit {
+    AttackTablesInit() {
+        Attacks::init();
+    }
+} _attackTablesInit;
@@ -0,0 +1,198 @@
+#include <boardDiff.hpp>
+
+#include <cstring>
+
+/// @brief  Defined when the SSE2 and AVX2 diff paths can be compiled for this target.
+///         SSE2 is part of x86-64, AVX2 is compiled per function and picked at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_SIMD_DIFF_PATH
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(HAS_SIMD_DIFF_PATH)
+/**
+ * @brief  Check whether the CPU and the OS support AVX2
+ * @return true if AVX2 instructions can run
+ */
+static bool _cpuHasAvx2() {
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    regs[0] = static_cast<unsigned int>(info[0]);
+#else
+    __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if (regs[0] < 7) {
+        return false;
+    }
+
+    // Leaf 1, ECX bit 27: OSXSAVE, the OS saves extended registers
+#if defined(_MSC_VER)
+    __cpuid(info, 1);
+    regs[2] = static_cast<unsigned int>(info[2]);
+#else
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if (!(regs[2] & (1u << 27))) {
+        return false;
+    }
+
+    // XCR0 bits 1 and 2: the OS saves the XMM and YMM registers on context switches
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int xcr0Low;
+    unsigned int xcr0High;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    unsigned long long xcr0 = xcr0Low | (static_cast<unsigned long long>(xcr0High) << 32);
+#endif
+    if ((xcr0 & 6) != 6) {
+        return false;
+    }
+
+    // Leaf 7, EBX bit 5: AVX2
+#if defined(_MSC_VER)
+    __cpuidex(info, 7, 0);
+    regs[1] = static_cast<unsigned int>(info[1]);
+#else
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    return (regs[1] & (1u << 5)) != 0;
+}
+
+/// @brief  Picked once during static initialization, the SSE2 path is used until then
+static const bool _useAvx2 = _cpuHasAvx2();
+
+/// @brief  AVX2 diff, 2 x 32 squares. Compiled for AVX2 without building the whole program with -mavx2
+#if !defined(_MSC_VER)
+__attribute__((target("avx2")))
+#endif
+static Bitboard _changedSquaresAvx2(const uint8_t* a, const uint8_t* b) {
+    const __m256i codeMask = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    Bitboard same = 0;
+    for (int i = 0; i < SQUARE_NB; i += 32) {
+        __m256i diff = _mm256_and_si256(_mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))), codeMask);
+        same |= Bitboard(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(diff, zero)))) << i;
+    }
+    return ~same;
+}
+
+/// @brief  SSE2 diff, 4 x 16 squares
+static Bitboard _changedSquaresSse2(const uint8_t* a, const uint8_t* b) {
+    const __m128i codeMask = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    Bitboard same = 0;
+    for (int i = 0; i < SQUARE_NB; i += 16) {
+        __m128i diff = _mm_and_si128(_mm_xor_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))), codeMask);
+        same |= Bitboard(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)))) << i;
+    }
+    return ~same;
+}
+#else
+/// @brief  Portable diff, one rank per word: fold every byte's nibble into its lowest bit, then gather those bits
+static Bitboard _changedSquaresScalar(const uint8_t* a, const uint8_t* b) {
+    Bitboard changed = 0;
+    for (int rank = 0; rank < 8; rank++) {
+        uint64_t wordA;
+        uint64_t wordB;
+        memcpy(&wordA, a + 8 * rank, sizeof(wordA));
+        memcpy(&wordB, b + 8 * rank, sizeof(wordB));
+        uint64_t diff = (wordA ^ wordB) & 0x0F0F0F0F0F0F0F0FULL;
+        diff = (diff | (diff >> 1) | (diff >> 2) | (diff >> 3)) & 0x0101010101010101ULL;
+        changed |= ((diff * 0x0102040810204080ULL) >> 56) << (8 * rank);
+    }
+    return changed;
+}
+#endif
+
+Bitboard BoardDiff::changedSquares(const Piece* before, const Piece* after) {
+    // Pieces are single bytes, the low nibble holds the color and kind
+    const uint8_t* a = reinterpret_cast<const uint8_t*>(before);
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(after);
+
+#if defined(HAS_SIMD_DIFF_PATH)
+    return _useAvx2 ? _changedSquaresAvx2(a, b) : _changedSquaresSse2(a, b);
+#else
+    return _changedSquaresScalar(a, b);
+#endif
+}
+
+/**
+ * @brief  Check whether two pieces have the same color and kind
+ */
+static bool _samePiece(Piece a, Piece b) {
+    return a.getType() == b.getType();
+}
+
+/**
+ * @brief  Check whether a move accounts for every changed square, and only those
+ * @param  before: The pieces before the move
+ * @param  after: The pieces after the move
+ * @param  move: A legal move of the position before
+ * @param  changed: The changed squares, see changedSquares
+ * @return true if playing the move turns before into after
+ */
+static bool _explains(const Piece* before, const Piece* after, Move move, Bitboard changed) {
+    int from = move.from();
+    int to = move.to();
+    Bitboard expected = squareBB(from) | squareBB(to);
+
+    Piece piece = before[from];
+    Piece placed = move.isPromotion() ? Piece::make(piece.getColor(), move.promotionKind()) : piece;
+    if (!after[from].isEmpty() || !_samePiece(after[to], placed)) {
+        return false;
+    }
+
+    if (move.type() == Move::EN_PASSANT) {
+        int capturedSquare = squareOf(fileOf(to), rankOf(from));
+        expected |= squareBB(capturedSquare);
+        if (!after[capturedSquare].isEmpty()) {
+            return false;
+        }
+    } else if (move.type() == Move::CASTLING) {
+        int rookFrom = squareOf(to > from ? 7 : 0, rankOf(from));
+        int rookTo = squareOf(to > from ? 5 : 3, rankOf(from));
+        expected |= squareBB(rookFrom) | squareBB(rookTo);
+        if (!after[rookFrom].isEmpty() || !_samePiece(after[rookTo], before[rookFrom])) {
+            return false;
+        }
+    }
+    return expected == changed;
+}
+
+Move BoardDiff::inferMove(const ChessBoard& before, const ChessBoard& after) {
+    Bitboard changed = changedSquares(before, after);
+
+    // A move changes 2 squares, 3 for en passant and 4 for castling
+    int count = popCount(changed);
+    if (count < 2 || count > 4) {
+        return Move::none();
+    }
+
+    MoveList moves;
+    before.generateLegalMoves(moves);
+    for (Move move : moves) {
+        if ((changed & squareBB(move.from())) && (changed & squareBB(move.to()))
+            && _explains(before.squares(), after.squares(), move, changed)) {
+            return move;
+        }
+    }
+    return Move::none();
+}
+
+const char* BoardDiff::implementation() {
+#if defined(HAS_SIMD_DIFF_PATH)
+    return _useAvx2 ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
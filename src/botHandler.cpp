@@ -78,7 +78,7 @@ string httpsGet(const string& host, const string& port, const string& target) {
     }
 }
 
-string encodeFen(const string& fen) {
+string encodeFen(string_view fen) {
     string result;
 
     for(char c : fen)
@@ -101,42 +101,66 @@ string encodeFen(const string& fen) {
     return result;
 }
 
-void getBotMove(ChessBoard* board){
+bool getBotMove(ChessBoard* board){
     // The FEN string needs to be URL encoded
     string depth = "12";
     
-    // Encode the FEN string
-    string encodedFen = encodeFen(board->boardToFEN());
-    cout << "FEN : " << board->boardToFEN() << endl;
+    // Encode the FEN string, both reads come from the board's FEN cache
+    string encodedFen = encodeFen(board->getFEN());
+    cout << "FEN : " << board->getFEN() << endl;
     
     // Build the full path with encoded parameters
     string path = "/api/s/v2.php?fen=" + encodedFen + "&depth=" + depth;
     
     string response = httpsGet("stockfish.online", "443", path);
-    auto responseJson = json::parse(response);
 
-    string botMoveStr = (responseJson["bestmove"].is_null() ? "none" : responseJson["bestmove"]);
-    float eval = (responseJson["evaluation"].is_null() ? -3 : (responseJson["evaluation"].is_number_float() ? responseJson["evaluation"].get<float>() : -2));
-    string mate = (responseJson["mate"].is_null() ? "none" : responseJson["mate"]);
-    bool successState = responseJson["success"];
+    // httpsGet returns an empty string on network failures, and any field may be missing
+    // or of an unexpected type: a bad reply is reported, never thrown out of the game loop
+    string botMoveStr;
+    float eval;
+    string mate;
+    bool successState;
+    try {
+        json responseJson = json::parse(response);
+        if (!responseJson.is_object()) {
+            cout << "Rejected bot reply: not a JSON object" << endl;
+            return false;
+        }
 
-    string nextMove = botMoveStr.substr(botMoveStr.find("bestmove ") + 9);
-    nextMove = nextMove.substr(0, 4);
+        const json& bestMove = responseJson.value("bestmove", json());
+        const json& evaluation = responseJson.value("evaluation", json());
+        const json& mateIn = responseJson.value("mate", json());
+        botMoveStr = bestMove.is_string() ? bestMove.get<string>() : "none";
+        eval = evaluation.is_null() ? -3 : (evaluation.is_number() ? evaluation.get<float>() : -2);
+        mate = mateIn.is_string() ? mateIn.get<string>() : (mateIn.is_number_integer() ? to_string(mateIn.get<int>()) : "none");
+        const json& success = responseJson.value("success", json());
+        successState = success.is_boolean() && success.get<bool>();
+    } catch (const json::exception& e) {
+        cout << "Rejected bot reply: " << e.what() << endl;
+        return false;
+    }
+
+    // "bestmove e7e8q ponder ...", the move is the token after "bestmove"
+    size_t start = botMoveStr.find("bestmove ");
+    start = (start == string::npos) ? 0 : start + 9;
+    string nextMove = botMoveStr.substr(start, botMoveStr.find_first_of(" \r\n", start) - start);
 
     cout << "Bot Move: " << nextMove << endl;
     cout << "Evaluation: " << eval << endl;
     cout << "Mate in: " << mate << endl;
     cout << "Success: " << (successState ? "true" : "false") << endl;
 
-    board->movePiece(
-        nextMove[0] - 'a',
-        nextMove[1] - '1',
-        nextMove[2] - 'a',
-        nextMove[3] - '1'
-    );
+    // A malformed or illegal reply must not touch the board
+    MoveError error;
+    Move move = board->parseStrMove(nextMove, &error);
+    if (!error.ok()) {
+        cout << "Rejected bot move: " << error.message << endl;
+        return false;
+    }
+    board->makeMove(move);
 
-    // Move move = board->parseStrMove(nextMove);
     board->eval = eval;
-    board->isMate = (mate != "none");
-    // board->selectPieceMove(&move);
+    // The remote mate field announces a forced mate ahead, the board itself says whether it happened
+    board->isMate = (board->gameState() == GameState::CHECKMATE);
+    return true;
 }
\ No newline at end of file
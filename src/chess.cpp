@@ -1,227 +1,990 @@
 #include <chess.hpp>
+#include <zobrist.hpp>
 
-static int _pieceCounter = 0;
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+static_assert(sizeof(Piece) == 1, "Piece must stay byte-sized");
+static_assert(is_trivially_copyable<Piece>::value, "Piece must stay trivially copyable");
+static_assert(sizeof(Move) == 2, "Move must stay packed in 16 bits");
+static_assert(is_trivially_copyable<Move>::value && is_trivially_default_constructible<Move>::value, "MoveList must not initialize its moves");
+static_assert(is_trivially_copyable<UndoInfo>::value, "UndoStack copies its entries with memcpy");
+static_assert(is_trivially_default_constructible<UndoInfo>::value, "UndoStack must not initialize its whole ring on construction");
+static_assert(is_nothrow_copy_constructible<ChessBoard>::value && is_nothrow_move_constructible<ChessBoard>::value, "ChessBoard snapshots must not throw");
+
+/// @brief  Piece type characters indexed by piece code (0 for empty, then color * 6 + kind + 1)
+static const char _pieceChars[13] = {
+    PieceType::EMPTY,
+    PieceType::WHITE_PAWN, PieceType::WHITE_KNIGHT, PieceType::WHITE_BISHOP, PieceType::WHITE_ROOK, PieceType::WHITE_QUEEN, PieceType::WHITE_KING,
+    PieceType::BLACK_PAWN, PieceType::BLACK_KNIGHT, PieceType::BLACK_BISHOP, PieceType::BLACK_ROOK, PieceType::BLACK_QUEEN, PieceType::BLACK_KING
+};
+
+/**
+ * @brief  Get the piece code of a piece type character
+ * @param  type: The piece type, check PieceType for reference
+ * @return The piece code, 0 if the character is not a piece
+ */
+static uint8_t _pieceCode(char type) {
+    switch (type) {
+        case PieceType::WHITE_PAWN:   return 1;
+        case PieceType::WHITE_KNIGHT: return 2;
+        case PieceType::WHITE_BISHOP: return 3;
+        case PieceType::WHITE_ROOK:   return 4;
+        case PieceType::WHITE_QUEEN:  return 5;
+        case PieceType::WHITE_KING:   return 6;
+        case PieceType::BLACK_PAWN:   return 7;
+        case PieceType::BLACK_KNIGHT: return 8;
+        case PieceType::BLACK_BISHOP: return 9;
+        case PieceType::BLACK_ROOK:   return 10;
+        case PieceType::BLACK_QUEEN:  return 11;
+        case PieceType::BLACK_KING:   return 12;
+        default:                      return 0;
+    }
+}
 
 Piece::Piece(char type, char state)
 {
-    _type = type;
-    _state = state;
-    _id = _pieceCounter;
-    _pieceCounter++;
+    uint8_t stateIndex = (state == PieceState::EMPTY) ? 0 : static_cast<uint8_t>(state - '0');
+    _code = static_cast<uint8_t>(_pieceCode(type) | (stateIndex << 4));
+}
+
+Piece Piece::make(int color, int kind)
+{
+    Piece piece;
+    piece._code = static_cast<uint8_t>((color * 6 + kind + 1) | ((PieceState::NORMAL - '0') << 4));
+    return piece;
 }
 
 void Piece::capture()
 {
-    _state = PieceState::CAPTURED;
+    _code = static_cast<uint8_t>((_code & 0x0F) | ((PieceState::CAPTURED - '0') << 4));
 }
 
 char Piece::getType() const
 {
-    return _type;
+    return _pieceChars[_code & 0x0F];
 }
 
 char Piece::getState() const
 {
-    return _state;
+    int stateIndex = _code >> 4;
+    return (stateIndex == 0) ? static_cast<char>(PieceState::EMPTY) : static_cast<char>('0' + stateIndex);
 }
 
-int Piece::getId() const
+string Move::toUCI() const
 {
-    return _id;
+    if (*this == Move::none()) {
+        return "0000";
+    }
+
+    string uci;
+    uci += static_cast<char>('a' + fromX());
+    uci += static_cast<char>('1' + fromY());
+    uci += static_cast<char>('a' + toX());
+    uci += static_cast<char>('1' + toY());
+    if (isPromotion()) {
+        uci += Piece::make(PieceColor::BLACK, promotionKind()).getType();
+    }
+    return uci;
 }
 
 ChessBoard::ChessBoard(bool startingPosition){
-    _board = new Piece**[8];
-    for (int i = 0; i < 8; i++) {
-        _board[i] = new Piece*[8];
-        for (int j = 0; j < 8; j++) {
-            _board[i][j] = nullptr;
-        }
-    }
+    // Boards may be constructed during static initialization, before bitboard.cpp's own initializers
+    Attacks::init();
+    _clearBoard();
 
     eval = 0.0f;
 
     resetBoard(startingPosition);
 }
 
+void ChessBoard::_clearBoard() {
+    for (int square = 0; square < SQUARE_NB; square++) {
+        _squares[square] = Piece();
+    }
+    for (int kind = 0; kind < 6; kind++) {
+        _byKind[kind] = 0;
+    }
+    _byColor[PieceColor::WHITE] = 0;
+    _byColor[PieceColor::BLACK] = 0;
+    _occupied = 0;
+    _material[PieceColor::WHITE] = 0;
+    _material[PieceColor::BLACK] = 0;
+    _phase = 0;
+    _key = 0;
+    _fenDirtyRanks = 0xFF;
+}
+
+void ChessBoard::_addPiece(int square, Piece piece) {
+    assert(!piece.isEmpty() && _squares[square].isEmpty() && "_addPiece puts a piece on an empty square");
+    Bitboard bb = squareBB(square);
+    _squares[square] = piece;
+    _fenDirtyRanks |= static_cast<uint8_t>(1 << rankOf(square));
+    _key ^= Zobrist::keys.piece[piece.getColor() * 6 + piece.getKind()][square];
+    _byKind[piece.getKind()] |= bb;
+    _byColor[piece.getColor()] |= bb;
+    _occupied |= bb;
+    _material[piece.getColor()] += PieceValue::material[piece.getKind()];
+    _phase += PieceValue::phase[piece.getKind()];
+}
+
+void ChessBoard::_removePiece(int square) {
+    Piece piece = _squares[square];
+    if (piece.isEmpty()) {
+        return;
+    }
+
+    Bitboard mask = ~squareBB(square);
+    _squares[square] = Piece();
+    _fenDirtyRanks |= static_cast<uint8_t>(1 << rankOf(square));
+    _key ^= Zobrist::keys.piece[piece.getColor() * 6 + piece.getKind()][square];
+    _byKind[piece.getKind()] &= mask;
+    _byColor[piece.getColor()] &= mask;
+    _occupied &= mask;
+    _material[piece.getColor()] -= PieceValue::material[piece.getKind()];
+    _phase -= PieceValue::phase[piece.getKind()];
+}
+
+int ChessBoard::pieceList(int color, int* squares, int capacity) const {
+    int count = 0;
+    for (int kind = PieceKind::PAWN; kind <= PieceKind::KING; kind++) {
+        Bitboard bb = pieces(color, kind);
+        while (bb && count < capacity) {
+            squares[count++] = popLsb(bb);
+        }
+    }
+    return count;
+}
+
 void ChessBoard::resetBoard(bool startingPosition) {
     if (startingPosition) {
         FENToBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
     } 
     else {
-        for (int i = 0; i < 8; i++) {
-            for (int j = 0; j < 8; j++) {
-                _board[i][j] = nullptr;
-            }
-        }
+        _clearBoard();
+        _undo.clear();
 
-        enPassantTarget = nullptr;
+        enPassantTarget = NO_SQUARE;
         turn = WHITE_TURN;
         wck = true;
         wcq = true;
         bck = true;
         bcq = true;
         moveCount = 1;
+        halfmoveClock = 0;
+        refreshKey();
+    }
+}
+
+const Piece* ChessBoard::getPieceAt(int file, int rank) const
+{
+    const Piece* piece = &_squares[squareOf(file, rank)];
+    return piece->isEmpty() ? nullptr : piece;
+}
+
+void ChessBoard::setPieceAt(int x, int y, Piece piece)
+{
+    int square = squareOf(x, y);
+
+    // Changing pawns can make the en passant target capturable or not
+    _key ^= _enPassantKey();
+    _removePiece(square);
+    if (!piece.isEmpty()) {
+        _addPiece(square, piece);
+    }
+    _key ^= _enPassantKey();
+    _updateCheckInfo();
+}
+
+Move ChessBoard::_inferMove(int from, int to, int promotionKind) const
+{
+    int kind = _squares[from].getKind();
+    int us = _squares[from].getColor();
+    if (kind == PieceKind::KING && (to - from == 2 || from - to == 2)) {
+        // makeMove moves the rook as well, so it must be home with nothing in its way
+        int backRank = (us == PieceColor::WHITE) ? 0 : 7;
+        bool kingSide = to > from;
+        int rookSquare = squareOf(kingSide ? 7 : 0, backRank);
+        uint8_t right = static_cast<uint8_t>((kingSide ? CastlingRight::WHITE_KING_SIDE : CastlingRight::WHITE_QUEEN_SIDE) << (2 * us));
+        if (from == squareOf(4, backRank) && (_castlingBits() & right)
+            && (pieces(us, PieceKind::ROOK) & squareBB(rookSquare))
+            && !(Attacks::between[from][rookSquare] & _occupied)) {
+            return Move(from, to, Move::CASTLING);
+        }
+    }
+    if (kind == PieceKind::PAWN && rankOf(to) == (us == PieceColor::WHITE ? 7 : 0)) {
+        return Move(from, to, Move::PROMOTION, promotionKind);
+    }
+    if (kind == PieceKind::PAWN && to == enPassantTarget && fileOf(from) != fileOf(to) && _squares[to].isEmpty()
+        && (pieces(us ^ 1, PieceKind::PAWN) & squareBB(squareOf(fileOf(to), rankOf(from))))) {
+        return Move(from, to, Move::EN_PASSANT);
+    }
+    return Move(from, to);
+}
+
+void ChessBoard::movePiece(int fromX, int fromY, int toX, int toY, int promotionKind)
+{
+    int from = squareOf(fromX, fromY);
+    if (_squares[from].isEmpty()) {
+        return;
+    }
+    if (promotionKind < PieceKind::KNIGHT || promotionKind > PieceKind::QUEEN) {
+        promotionKind = PieceKind::QUEEN;
+    }
+    makeMove(_inferMove(from, squareOf(toX, toY), promotionKind));
+}
+
+/**
+ * @brief  Fill a MoveError and return the null move
+ * @param  error: The error to fill, may be nullptr
+ * @param  message: The static description of the problem
+ * @return Move::none()
+ */
+static Move _moveError(MoveError* error, const char* message) {
+    if (error) {
+        error->message = message;
+    }
+    return Move::none();
+}
+
+Move ChessBoard::parseStrMove(string_view uci, MoveError* error) const
+{
+    if (uci.size() != 4 && uci.size() != 5) {
+        return _moveError(error, "move must be 4 or 5 characters long");
+    }
+    if (uci[0] < 'a' || uci[0] > 'h' || uci[1] < '1' || uci[1] > '8'
+        || uci[2] < 'a' || uci[2] > 'h' || uci[3] < '1' || uci[3] > '8') {
+        return _moveError(error, "squares must be written as a file a-h and a rank 1-8");
+    }
+
+    int promotionKind = PieceKind::PAWN;
+    if (uci.size() == 5) {
+        switch (uci[4]) {
+            case 'n': promotionKind = PieceKind::KNIGHT; break;
+            case 'b': promotionKind = PieceKind::BISHOP; break;
+            case 'r': promotionKind = PieceKind::ROOK; break;
+            case 'q': promotionKind = PieceKind::QUEEN; break;
+            default:  return _moveError(error, "promotion piece must be one of n, b, r, q");
+        }
     }
+
+    int from = squareOf(uci[0] - 'a', uci[1] - '1');
+    int to = squareOf(uci[2] - 'a', uci[3] - '1');
+    if (_squares[from].isEmpty()) {
+        return _moveError(error, "no piece on the starting square");
+    }
+
+    Move move = _inferMove(from, to, promotionKind == PieceKind::PAWN ? PieceKind::QUEEN : promotionKind);
+    if (move.isPromotion() != (promotionKind != PieceKind::PAWN)) {
+        return _moveError(error, move.isPromotion() ? "promotion piece missing" : "only a pawn reaching the last rank can promote");
+    }
+
+    MoveList legal;
+    generateLegalMoves(legal);
+    if (!legal.contains(move)) {
+        return _moveError(error, "move is not legal in this position");
+    }
+    if (error) {
+        *error = MoveError();
+    }
+    return move;
+}
+
+uint8_t ChessBoard::_castlingBits() const {
+    return static_cast<uint8_t>((wck ? CastlingRight::WHITE_KING_SIDE : 0)
+                              | (wcq ? CastlingRight::WHITE_QUEEN_SIDE : 0)
+                              | (bck ? CastlingRight::BLACK_KING_SIDE : 0)
+                              | (bcq ? CastlingRight::BLACK_QUEEN_SIDE : 0));
+}
+
+void ChessBoard::_setCastlingBits(uint8_t bits) {
+    wck = (bits & CastlingRight::WHITE_KING_SIDE) != 0;
+    wcq = (bits & CastlingRight::WHITE_QUEEN_SIDE) != 0;
+    bck = (bits & CastlingRight::BLACK_KING_SIDE) != 0;
+    bcq = (bits & CastlingRight::BLACK_QUEEN_SIDE) != 0;
+}
+
+/**
+ * @brief  Build the castling rights kept when a move starts or ends on each square
+ * @return The CastlingRight masks indexed by square
+ */
+static constexpr array<uint8_t, SQUARE_NB> _makeCastlingMasks() {
+    array<uint8_t, SQUARE_NB> masks = {};
+    for (int square = 0; square < SQUARE_NB; square++) {
+        masks[square] = CastlingRight::ALL;
+    }
+    masks[squareOf(4, 0)] &= ~(CastlingRight::WHITE_KING_SIDE | CastlingRight::WHITE_QUEEN_SIDE);
+    masks[squareOf(7, 0)] &= ~CastlingRight::WHITE_KING_SIDE;
+    masks[squareOf(0, 0)] &= ~CastlingRight::WHITE_QUEEN_SIDE;
+    masks[squareOf(4, 7)] &= ~(CastlingRight::BLACK_KING_SIDE | CastlingRight::BLACK_QUEEN_SIDE);
+    masks[squareOf(7, 7)] &= ~CastlingRight::BLACK_KING_SIDE;
+    masks[squareOf(0, 7)] &= ~CastlingRight::BLACK_QUEEN_SIDE;
+    return masks;
+}
+
+/// @brief  Castling rights kept by a move from or to a square, a king or rook leaving
+///         home or a rook being captured at home loses the matching rights
+static constexpr array<uint8_t, SQUARE_NB> _castlingMasks = _makeCastlingMasks();
+
+UndoStack::UndoStack(const UndoStack& other) noexcept
+{
+    *this = other;
 }
 
-Piece* ChessBoard::getPieceAt(int file, int rank) const
+UndoStack& UndoStack::operator=(const UndoStack& other) noexcept
 {
-    return _board[file][rank];
+    if (this == &other) {
+        return *this;
+    }
+
+    // Copy the live window oldest first, a wrapped buffer comes out unwrapped at index 0
+    int start = (other._top + MAX_UNDO - other._size) % MAX_UNDO;
+    int head = min(other._size, MAX_UNDO - start);
+    memcpy(_entries, other._entries + start, head * sizeof(UndoInfo));
+    memcpy(_entries + head, other._entries, (other._size - head) * sizeof(UndoInfo));
+    _size = other._size;
+    _top = _size % MAX_UNDO;
+    return *this;
 }
 
-void ChessBoard::setPieceAt(int x, int y, Piece* piece)
+UndoInfo& UndoStack::push()
 {
-    _board[x][y] = piece;
+    UndoInfo& entry = _entries[_top];
+    _top = (_top + 1) % MAX_UNDO;
+    if (_size < MAX_UNDO) {
+        _size++;
+    }
+    return entry;
 }
 
-void ChessBoard::movePiece(int fromX, int fromY, int toX, int toY)
+const UndoInfo& UndoStack::pop()
 {
-    Piece* piece = getPieceAt(fromX, fromY);
-    
-    if (getPieceAt(toX, toY) != nullptr) {
-        
-        getPieceAt(toX, toY)->capture();
+    _top = (_top + MAX_UNDO - 1) % MAX_UNDO;
+    _size--;
+    return _entries[_top];
+}
+
+void ChessBoard::makeMove(Move move)
+{
+    int from = move.from();
+    int to = move.to();
+    Piece piece = _squares[from];
+    int us = piece.getColor();
+    int kind = piece.getKind();
+
+    UndoInfo& undo = _undo.push();
+    undo.key = _key;
+    undo.moveCount = moveCount;
+    undo.halfmoveClock = halfmoveClock;
+    undo.move = move;
+    undo.captured = _squares[to].getCode();
+    undo.castling = _castlingBits();
+    undo.enPassantTarget = static_cast<int8_t>(enPassantTarget);
+    undo.checkers = _checkers;
+    undo.pinned = _pinned;
+
+    // Side, castling and en passant terms are toggled back in once the move is done
+    _key ^= _enPassantKey() ^ Zobrist::keys.castling[undo.castling] ^ Zobrist::keys.blackToMove;
+
+    // En passant removes the pawn behind the target square
+    if (move.type() == Move::EN_PASSANT) {
+        int capturedSquare = squareOf(fileOf(to), rankOf(from));
+        undo.captured = _squares[capturedSquare].getCode();
+        _removePiece(capturedSquare);
+    }
+
+    // Captures and pawn moves cannot be undone over the board, they restart the clock
+    halfmoveClock = (kind == PieceKind::PAWN || !Piece::fromCode(undo.captured).isEmpty()) ? 0 : halfmoveClock + 1;
+
+    _removePiece(to);
+    _removePiece(from);
+    if (move.isPromotion()) {
+        _addPiece(to, Piece::make(us, move.promotionKind()));
+    } else {
+        _addPiece(to, piece);
+    }
+
+    // Castling is encoded as the king step, the rook jumps over the king
+    if (move.type() == Move::CASTLING) {
+        int rookFrom = squareOf(to > from ? 7 : 0, rankOf(from));
+        int rookTo = squareOf(to > from ? 5 : 3, rankOf(from));
+        Piece rook = _squares[rookFrom];
+        _removePiece(rookFrom);
+        _addPiece(rookTo, rook);
+    }
+
+    uint8_t castling = undo.castling & _castlingMasks[from] & _castlingMasks[to];
+    _setCastlingBits(castling);
+
+    // Only record an en passant target that an enemy pawn could actually capture on
+    enPassantTarget = NO_SQUARE;
+    if (kind == PieceKind::PAWN && (to - from == 16 || from - to == 16)) {
+        int target = (from + to) / 2;
+        if (Attacks::pawn[us][target] & pieces(us ^ 1, PieceKind::PAWN)) {
+            enPassantTarget = target;
+        }
     }
-    
-    setPieceAt(toX, toY, piece);
-    setPieceAt(fromX, fromY, nullptr);
+
     if (turn == WHITE_TURN) {
         turn = BLACK_TURN;
     } else {
         turn = WHITE_TURN;
         moveCount++;
     }
+    _key ^= _enPassantKey() ^ Zobrist::keys.castling[castling];
+    _updateCheckInfo();
 }
 
-string ChessBoard::boardToFEN() {
-    string fen;
-    string piecesPlacement = "";
+bool ChessBoard::unmakeMove()
+{
+    if (_undo.size() == 0) {
+        return false;
+    }
+    const UndoInfo& undo = _undo.pop();
+    Move move = undo.move;
 
-    for (int i = 7; i >= 0; i--) {
-        int emptyCount = 0;
-        for (int j = 0; j < 8; j++) {
-            Piece* piece = this->getPieceAt(j, i);
-            if (piece == nullptr) {
-                emptyCount++;
-            } else {
-                if (emptyCount > 0) {
-                    piecesPlacement += to_string(emptyCount);
-                    emptyCount = 0;
-                }
-                piecesPlacement += piece->getType();
-            }
+    int from = move.from();
+    int to = move.to();
+    Piece piece = _squares[to];
+    int us = piece.getColor();
+
+    if (move.isPromotion()) {
+        piece = Piece::make(us, PieceKind::PAWN);
+    }
+    _removePiece(to);
+    _addPiece(from, piece);
+
+    Piece captured = Piece::fromCode(undo.captured);
+    if (!captured.isEmpty()) {
+        _addPiece(move.type() == Move::EN_PASSANT ? squareOf(fileOf(to), rankOf(from)) : to, captured);
+    }
+
+    if (move.type() == Move::CASTLING) {
+        int rookFrom = squareOf(to > from ? 7 : 0, rankOf(from));
+        int rookTo = squareOf(to > from ? 5 : 3, rankOf(from));
+        Piece rook = _squares[rookTo];
+        _removePiece(rookTo);
+        _addPiece(rookFrom, rook);
+    }
+
+    _setCastlingBits(undo.castling);
+    enPassantTarget = undo.enPassantTarget;
+    moveCount = undo.moveCount;
+    halfmoveClock = undo.halfmoveClock;
+    turn = (us == PieceColor::WHITE) ? WHITE_TURN : BLACK_TURN;
+    _key = undo.key;
+    _checkers = undo.checkers;
+    _pinned = undo.pinned;
+    return true;
+}
+
+int ChessBoard::repetitionCount() const {
+    int window = min(halfmoveClock, _undo.size());
+    int count = 0;
+
+    // Entry ply holds the key from ply + 1 halfmoves ago. Only the same side to move can
+    // match, and a position needs at least four halfmoves to come back
+    for (int ply = 3; ply < window; ply += 2) {
+        if (_undo.peek(ply).key == _key) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool ChessBoard::isInsufficientMaterial() const {
+    if (_byKind[PieceKind::PAWN] | _byKind[PieceKind::ROOK] | _byKind[PieceKind::QUEEN]) {
+        return false;
+    }
+    Bitboard minors = _byKind[PieceKind::KNIGHT] | _byKind[PieceKind::BISHOP];
+    if (popCount(minors) <= 1) {
+        return true;
+    }
+
+    // Bishops bound to one square color can never cover a king and its flight squares
+    const Bitboard darkSquares = 0xAA55AA55AA55AA55ULL;
+    return !_byKind[PieceKind::KNIGHT] && (!(minors & darkSquares) || !(minors & ~darkSquares));
+}
+
+int ChessBoard::gameState() const {
+    MoveList moves;
+    generateLegalMoves(moves);
+    if (moves.size() == 0) {
+        return inCheck() ? GameState::CHECKMATE : GameState::STALEMATE;
+    }
+    if (isInsufficientMaterial()) {
+        return GameState::INSUFFICIENT_MATERIAL;
+    }
+    if (halfmoveClock >= 100) {
+        return GameState::FIFTY_MOVE_RULE;
+    }
+    if (repetitionCount() >= 2) {
+        return GameState::REPETITION;
+    }
+    return GameState::ONGOING;
+}
+
+const char* GameState::name(int state) {
+    switch (state) {
+        case CHECKMATE:             return "checkmate";
+        case STALEMATE:             return "stalemate";
+        case INSUFFICIENT_MATERIAL: return "insufficient material";
+        case FIFTY_MOVE_RULE:       return "50-move rule";
+        case REPETITION:            return "threefold repetition";
+        default:                    return "ongoing";
+    }
+}
+
+uint64_t ChessBoard::_enPassantKey() const {
+    if (enPassantTarget == NO_SQUARE) {
+        return 0;
+    }
+    int us = (turn == WHITE_TURN) ? PieceColor::WHITE : PieceColor::BLACK;
+    if (!(Attacks::pawn[us ^ 1][enPassantTarget] & pieces(us, PieceKind::PAWN))) {
+        return 0;
+    }
+    return Zobrist::keys.enPassant[fileOf(enPassantTarget)];
+}
+
+uint64_t ChessBoard::computeKey() const {
+    uint64_t key = 0;
+    Bitboard occupied = _occupied;
+    while (occupied) {
+        int square = popLsb(occupied);
+        Piece piece = _squares[square];
+        key ^= Zobrist::keys.piece[piece.getColor() * 6 + piece.getKind()][square];
+    }
+    key ^= Zobrist::keys.castling[_castlingBits()];
+    key ^= _enPassantKey();
+    if (turn == BLACK_TURN) {
+        key ^= Zobrist::keys.blackToMove;
+    }
+    return key;
+}
+
+/**
+ * @brief  Write a non-negative decimal number, negative values are written as 0
+ * @param  out: The write position, moved past the digits
+ * @param  value: The number to write
+ */
+static void _writeFenNumber(char*& out, int value) {
+    char digits[10];
+    int count = 0;
+    unsigned int v = (value > 0) ? static_cast<unsigned int>(value) : 0;
+    do {
+        digits[count++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+}
+
+uint8_t ChessBoard::_writeFenRank(int rank, char* out) const {
+    uint8_t length = 0;
+    int emptyCount = 0;
+    for (int file = 0; file < 8; file++) {
+        Piece piece = _squares[squareOf(file, rank)];
+        if (piece.isEmpty()) {
+            emptyCount++;
+            continue;
         }
         if (emptyCount > 0) {
-            piecesPlacement += to_string(emptyCount);
+            out[length++] = static_cast<char>('0' + emptyCount);
+            emptyCount = 0;
         }
-        if (i > 0) {
-            piecesPlacement += '/';
+        out[length++] = piece.getType();
+    }
+    if (emptyCount > 0) {
+        out[length++] = static_cast<char>('0' + emptyCount);
+    }
+    return length;
+}
+
+void ChessBoard::_writeFenTail(char*& out) const {
+    *out++ = ' ';
+    *out++ = turn;
+
+    *out++ = ' ';
+    if (!(wck || wcq || bck || bcq)) {
+        *out++ = '-';
+    }
+    if (wck) *out++ = 'K';
+    if (wcq) *out++ = 'Q';
+    if (bck) *out++ = 'k';
+    if (bcq) *out++ = 'q';
+
+    *out++ = ' ';
+    if (enPassantTarget == NO_SQUARE) {
+        *out++ = '-';
+    } else {
+        _convIntToChar(fileOf(enPassantTarget), rankOf(enPassantTarget), out, out + 1);
+        out += 2;
+    }
+
+    *out++ = ' ';
+    _writeFenNumber(out, halfmoveClock);
+
+    *out++ = ' ';
+    _writeFenNumber(out, moveCount);
+}
+
+string_view ChessBoard::getFEN() {
+    uint8_t castling = _castlingBits();
+    if (_fenDirtyRanks == 0 && _fenLength > 0
+        && _fenTurn == turn && _fenCastling == castling
+        && _fenEnPassant == enPassantTarget && _fenMoveCount == moveCount
+        && _fenHalfmoveClock == halfmoveClock) {
+        return string_view(_fen, _fenLength);
+    }
+
+    while (_fenDirtyRanks) {
+        int rank = lsb(_fenDirtyRanks);
+        _fenDirtyRanks &= static_cast<uint8_t>(_fenDirtyRanks - 1);
+        _fenRankLength[rank] = _writeFenRank(rank, _fenRanks[rank]);
+    }
+
+    char* out = _fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        memcpy(out, _fenRanks[rank], _fenRankLength[rank]);
+        out += _fenRankLength[rank];
+        if (rank > 0) {
+            *out++ = '/';
         }
     }
+    _writeFenTail(out);
+    *out = '\0';
 
-    string enPassantStr = "";
+    _fenLength = static_cast<size_t>(out - _fen);
+    _fenTurn = turn;
+    _fenCastling = castling;
+    _fenEnPassant = enPassantTarget;
+    _fenMoveCount = moveCount;
+    _fenHalfmoveClock = halfmoveClock;
+    return string_view(_fen, _fenLength);
+}
 
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            Piece* piece = this->getPieceAt(i, j);
-            if (piece != nullptr && (piece->getType() == PieceType::BLACK_PAWN || piece->getType() == PieceType::WHITE_PAWN)) {
-                if (enPassantTarget != nullptr && enPassantTarget->getId() == piece->getId()) {
-                    enPassantStr = string(1, i + 'a') + to_string(j + 1);
-                }
-            }
+size_t ChessBoard::writeFEN(char* buffer, size_t size) const {
+    if (size < MAX_FEN_LENGTH) {
+        return 0;
+    }
+
+    char* out = buffer;
+    for (int rank = 7; rank >= 0; rank--) {
+        out += _writeFenRank(rank, out);
+        if (rank > 0) {
+            *out++ = '/';
         }
     }
+    _writeFenTail(out);
+    *out = '\0';
+    return static_cast<size_t>(out - buffer);
+}
 
-    fen = 
-        piecesPlacement + " " + 
-        turn +
-        " " +
-        (wck ? "K" : "") +
-        (wcq ? "Q" : "") +
-        (bck ? "k" : "") +
-        (bcq ? "q" : "") +
-        (bcq || bck || wcq || wck ? "" : "-") +
-        " " +
-        (enPassantTarget != nullptr ? enPassantStr : "-") +
-        " 0 " +
-        to_string(moveCount);
+string ChessBoard::boardToFEN() const {
+    char buffer[MAX_FEN_LENGTH];
+    return string(buffer, writeFEN(buffer, sizeof(buffer)));
+}
 
-    return fen;    
+/**
+ * @brief  Build a FenError
+ * @param  field: The failing field, check FenField for reference
+ * @param  offset: The character offset in the FEN
+ * @param  message: A static description
+ * @return The error
+ */
+static FenError _fenError(int field, size_t offset, const char* message) {
+    FenError error;
+    error.field = field;
+    error.offset = offset;
+    error.message = message;
+    return error;
 }
 
-void ChessBoard::FENToBoard(const string& fen) {
-    // Split FEN string into its components
+FenError ChessBoard::_checkPosition(const Piece* squares, char turn, int enPassantTarget) {
+    Bitboard byKind[6] = { 0, 0, 0, 0, 0, 0 };
+    Bitboard byColor[2] = { 0, 0 };
+    for (int square = 0; square < SQUARE_NB; square++) {
+        Piece piece = squares[square];
+        if (!piece.isEmpty()) {
+            byKind[piece.getKind()] |= squareBB(square);
+            byColor[piece.getColor()] |= squareBB(square);
+        }
+    }
+    Bitboard occupied = byColor[PieceColor::WHITE] | byColor[PieceColor::BLACK];
+
+    for (int color = PieceColor::WHITE; color <= PieceColor::BLACK; color++) {
+        int count[6];
+        for (int kind = PieceKind::PAWN; kind <= PieceKind::KING; kind++) {
+            count[kind] = popCount(byKind[kind] & byColor[color]);
+        }
+        if (count[PieceKind::KING] != 1) {
+            return _fenError(FenField::PLACEMENT, 0, "each side needs exactly one king");
+        }
+
+        // Every piece beyond the starting set stands for a pawn that promoted
+        int promoted = max(count[PieceKind::KNIGHT] - 2, 0) + max(count[PieceKind::BISHOP] - 2, 0)
+                     + max(count[PieceKind::ROOK] - 2, 0) + max(count[PieceKind::QUEEN] - 1, 0);
+        if (count[PieceKind::PAWN] + promoted > 8) {
+            return _fenError(FenField::PLACEMENT, 0, "more pieces than a side can have after promotions");
+        }
+    }
+    if (byKind[PieceKind::PAWN] & 0xFF000000000000FFULL) {
+        return _fenError(FenField::PLACEMENT, 0, "pawns cannot stand on the first or last rank");
+    }
+
+    // The side to move would capture the enemy king
+    int us = (turn == WHITE_TURN) ? PieceColor::WHITE : PieceColor::BLACK;
+    int them = us ^ 1;
+    int kingSquare = lsb(byKind[PieceKind::KING] & byColor[them]);
+    Bitboard attackers = (Attacks::pawn[them][kingSquare] & byKind[PieceKind::PAWN])
+                       | (Attacks::knight[kingSquare] & byKind[PieceKind::KNIGHT])
+                       | (Attacks::king[kingSquare] & byKind[PieceKind::KING])
+                       | (Attacks::bishop(kingSquare, occupied) & (byKind[PieceKind::BISHOP] | byKind[PieceKind::QUEEN]))
+                       | (Attacks::rook(kingSquare, occupied) & (byKind[PieceKind::ROOK] | byKind[PieceKind::QUEEN]));
+    if (attackers & byColor[us]) {
+        return _fenError(FenField::ACTIVE_COLOR, 0, "the side not to move is in check");
+    }
+
+    // The pawn that just moved two squares stands in front of the target, its start square is empty
+    if (enPassantTarget != NO_SQUARE) {
+        int forward = (us == PieceColor::WHITE) ? 8 : -8;
+        Bitboard pushed = squareBB(enPassantTarget - forward);
+        Bitboard vacated = squareBB(enPassantTarget) | squareBB(enPassantTarget + forward);
+        if (!(byKind[PieceKind::PAWN] & byColor[them] & pushed) || (occupied & vacated)) {
+            return _fenError(FenField::EN_PASSANT, 0, "en passant target needs the pawn that just moved in front of it");
+        }
+    }
+    return FenError();
+}
+
+/**
+ * @brief  Parse a bounded decimal number of a FEN
+ * @param  fen: The FEN
+ * @param  pos: The read position, moved past the digits
+ * @param  maxValue: The largest accepted value
+ * @param  outValue: Reference to store the value
+ * @return false if there is no digit or the value is too large
+ */
+static bool _parseFenNumber(string_view fen, size_t& pos, int maxValue, int *outValue) {
+    size_t start = pos;
+    int value = 0;
+    while (pos < fen.size() && fen[pos] >= '0' && fen[pos] <= '9') {
+        value = value * 10 + (fen[pos] - '0');
+        if (value > maxValue) {
+            return false;
+        }
+        pos++;
+    }
+    *outValue = value;
+    return pos > start;
+}
+
+/**
+ * @brief  Skip the single space separating two FEN fields
+ * @param  fen: The FEN
+ * @param  pos: The read position, moved past the space
+ * @return false if the field does not end with a space
+ */
+static bool _skipFenSpace(string_view fen, size_t& pos) {
+    if (pos >= fen.size() || fen[pos] != ' ') {
+        return false;
+    }
+    while (pos < fen.size() && fen[pos] == ' ') {
+        pos++;
+    }
+    return true;
+}
+
+FenError ChessBoard::FENToBoard(string_view fen) {
+    // Everything is parsed into locals first so a bad FEN leaves the board untouched
+    Piece squares[SQUARE_NB];
     size_t pos = 0;
-    size_t nextSpace = fen.find(' ', pos);
-    string piecesPlacement = fen.substr(pos, nextSpace - pos);
-    
-    // Parse piece placement
+    while (pos < fen.size() && fen[pos] == ' ') {
+        pos++;
+    }
+
+    // Piece placement, from rank 8 down to rank 1
+    size_t placementStart = pos;
     int rank = 7;
     int file = 0;
-    for (size_t i = 0; i < piecesPlacement.length(); i++) {
-        char c = piecesPlacement[i];
-        
+    bool lastWasDigit = false;
+    for (; pos < fen.size() && fen[pos] != ' '; pos++) {
+        char c = fen[pos];
+        if (c >= '1' && c <= '8' && lastWasDigit) {
+            return _fenError(FenField::PLACEMENT, pos, "consecutive empty-square counts");
+        }
+        lastWasDigit = (c >= '1' && c <= '8');
         if (c == '/') {
+            if (file != 8 || rank == 0) {
+                return _fenError(FenField::PLACEMENT, pos, "rank does not have 8 files");
+            }
             rank--;
             file = 0;
-        } else if (isdigit(c)) {
-            // Empty squares
-            int emptyCount = c - '0';
-            for (int j = 0; j < emptyCount; j++) {
-                _board[file][rank] = nullptr;
-                file++;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) {
+                return _fenError(FenField::PLACEMENT, pos, "rank has more than 8 files");
             }
         } else {
-            // Piece
-            Piece* piece = new Piece(c);
-            _board[file][rank] = piece;
+            Piece piece(c);
+            if (piece.isEmpty()) {
+                return _fenError(FenField::PLACEMENT, pos, "unknown piece");
+            }
+            if (file >= 8) {
+                return _fenError(FenField::PLACEMENT, pos, "rank has more than 8 files");
+            }
+            squares[squareOf(file, rank)] = piece;
             file++;
         }
     }
-    
-    // Parse active color (turn)
-    pos = nextSpace + 1;
-    nextSpace = fen.find(' ', pos);
-    if (nextSpace != string::npos) {
-        turn = fen[pos];
-    }
-    
-    // Parse castling rights
-    pos = nextSpace + 1;
-    nextSpace = fen.find(' ', pos);
-    if (nextSpace != string::npos) {
-        string castling = fen.substr(pos, nextSpace - pos);
-        wck = (castling.find('K') != string::npos);
-        wcq = (castling.find('Q') != string::npos);
-        bck = (castling.find('k') != string::npos);
-        bcq = (castling.find('q') != string::npos);
-    }
-    
-    // Parse en passant target
-    pos = nextSpace + 1;
-    nextSpace = fen.find(' ', pos);
-    if (nextSpace != string::npos) {
-        string enPassant = fen.substr(pos, nextSpace - pos);
-        if (enPassant != "-") {
-            // Convert algebraic notation to coordinates (e.g., "e3" -> x=4, y=2)
-            int epFile = enPassant[0] - 'a';
-            int epRank = enPassant[1] - '1';
-            enPassantTarget = this->getPieceAt(epFile, epRank);
-        } else {
-            enPassantTarget = nullptr;
+    if (rank != 0 || file != 8) {
+        return _fenError(FenField::PLACEMENT, pos, "placement does not cover 8 ranks");
+    }
+
+    // Active color
+    if (!_skipFenSpace(fen, pos)) {
+        return _fenError(FenField::ACTIVE_COLOR, pos, "missing active color");
+    }
+    size_t turnStart = pos;
+    if (pos >= fen.size() || (fen[pos] != WHITE_TURN && fen[pos] != BLACK_TURN)) {
+        return _fenError(FenField::ACTIVE_COLOR, pos, "active color must be 'w' or 'b'");
+    }
+    char newTurn = fen[pos++];
+
+    // Castling rights
+    if (!_skipFenSpace(fen, pos)) {
+        return _fenError(FenField::CASTLING, pos, "missing castling rights");
+    }
+    uint8_t castling = 0;
+    if (pos < fen.size() && fen[pos] == '-') {
+        pos++;
+    } else {
+        size_t start = pos;
+        for (; pos < fen.size() && fen[pos] != ' '; pos++) {
+            uint8_t right;
+            switch (fen[pos]) {
+                case 'K': right = CastlingRight::WHITE_KING_SIDE; break;
+                case 'Q': right = CastlingRight::WHITE_QUEEN_SIDE; break;
+                case 'k': right = CastlingRight::BLACK_KING_SIDE; break;
+                case 'q': right = CastlingRight::BLACK_QUEEN_SIDE; break;
+                default: return _fenError(FenField::CASTLING, pos, "castling rights must be '-' or from 'KQkq'");
+            }
+            if (castling & right) {
+                return _fenError(FenField::CASTLING, pos, "repeated castling right");
+            }
+            castling |= right;
+        }
+        if (pos == start) {
+            return _fenError(FenField::CASTLING, pos, "missing castling rights");
         }
     }
-    
-    // Parse halfmove clock (skipped for now as it's not stored in ChessBoard)
-    pos = nextSpace + 1;
-    nextSpace = fen.find(' ', pos);
-    
-    // Parse fullmove number
-    if (nextSpace != string::npos) {
-        pos = nextSpace + 1;
-        moveCount = stoi(fen.substr(pos));
+
+    // En passant target, behind a pawn of the side that just moved: rank 6 when white
+    // is to move, rank 3 when black is
+    if (!_skipFenSpace(fen, pos)) {
+        return _fenError(FenField::EN_PASSANT, pos, "missing en passant target");
     }
+    size_t enPassantStart = pos;
+    int newEnPassant = NO_SQUARE;
+    if (pos < fen.size() && fen[pos] == '-') {
+        pos++;
+    } else {
+        char targetRank = (newTurn == WHITE_TURN) ? '6' : '3';
+        if (pos + 1 >= fen.size() || fen[pos] < 'a' || fen[pos] > 'h' || fen[pos + 1] != targetRank) {
+            return _fenError(FenField::EN_PASSANT, pos, newTurn == WHITE_TURN
+                ? "en passant target must be '-' or a square on rank 6 with white to move"
+                : "en passant target must be '-' or a square on rank 3 with black to move");
+        }
+        newEnPassant = squareOf(fen[pos] - 'a', fen[pos + 1] - '1');
+        pos += 2;
+    }
+
+    // Halfmove clock and fullmove number, both optional
+    int newHalfmoveClock = 0;
+    int fullmoveNumber = 1;
+    if (pos < fen.size() && !_skipFenSpace(fen, pos)) {
+        return _fenError(FenField::EN_PASSANT, pos, "unexpected characters after the en passant target");
+    }
+    if (pos < fen.size()) {
+        if (!_parseFenNumber(fen, pos, 9999, &newHalfmoveClock)) {
+            return _fenError(FenField::HALFMOVE_CLOCK, pos, "halfmove clock must be a number up to 9999");
+        }
+        if (!_skipFenSpace(fen, pos) || !_parseFenNumber(fen, pos, 99999, &fullmoveNumber) || fullmoveNumber == 0) {
+            return _fenError(FenField::FULLMOVE_NUMBER, pos, "fullmove number must be a number from 1 to 99999");
+        }
+        while (pos < fen.size() && fen[pos] == ' ') {
+            pos++;
+        }
+        if (pos < fen.size()) {
+            return _fenError(FenField::FULLMOVE_NUMBER, pos, "unexpected characters after the fullmove number");
+        }
+    }
+
+    FenError error = _checkPosition(squares, newTurn, newEnPassant);
+    if (!error.ok()) {
+        error.offset = (error.field == FenField::EN_PASSANT) ? enPassantStart
+                     : (error.field == FenField::ACTIVE_COLOR) ? turnStart : placementStart;
+        return error;
+    }
+
+    // Commit, a new position has no moves to take back
+    _clearBoard();
+    _undo.clear();
+    for (int square = 0; square < SQUARE_NB; square++) {
+        if (!squares[square].isEmpty()) {
+            _addPiece(square, squares[square]);
+        }
+    }
+    turn = newTurn;
+    _setCastlingBits(castling);
+    enPassantTarget = newEnPassant;
+    moveCount = fullmoveNumber;
+    halfmoveClock = newHalfmoveClock;
+    refreshKey();
+
+    return FenError();
+}
+
+BulkLoadStats ChessBoard::loadFENStream(istream& in, const function<void(const ChessBoard&)>& onPosition) {
+    BulkLoadStats stats;
+    string line;
+    line.reserve(128);
+
+    auto start = chrono::steady_clock::now();
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        if (!FENToBoard(line).ok()) {
+            stats.failures++;
+            continue;
+        }
+
+        stats.positions++;
+        if (onPosition) {
+            onPosition(*this);
+        }
+    }
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
+
+double BulkLoadStats::positionsPerSecond() const {
+    return (seconds > 0.0) ? positions / seconds : 0.0;
+}
+
+void BulkLoadStats::print() const {
+    cout << "Loaded " << positions << " positions (" << failures << " failed) in "
+         << seconds << " s, " << static_cast<long long>(positionsPerSecond()) << " positions/s" << endl;
 }
 
 void ChessBoard::_convIntToChar(int file, int rank, char *outFile, char *outRank) {
@@ -238,7 +1001,7 @@ void ChessBoard::printBoard() const {
     for (int rank = 7; rank >= 0; rank--) {
         cout << rank + 1 << " ";
         for (int file = 0; file < 8; file++) {
-            Piece* piece = getPieceAt(file, rank);
+            const Piece* piece = getPieceAt(file, rank);
             if (piece != nullptr) {
                 cout << piece->getType() << " ";
             } else {
@@ -1,15 +1,34 @@
 #include <botHandler.hpp>
 #include <chess.hpp>
+#include <fstream>
 
 using namespace std;
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Throughput mode: stream a file of FENs through a single board
+    if (argc == 3 && string(argv[1]) == "--load-fens") {
+        ifstream file(argv[2]);
+        if (!file) {
+            cout << "Cannot open " << argv[2] << endl;
+            return 1;
+        }
+        ChessBoard board(false);
+        board.loadFENStream(file).print();
+        return 0;
+    }
+
     ChessBoard board(true); // Standard starting position, bot plays black
     board.printBoard();
-    for (int i = 0; i < 3; i++) {
-        getBotMove(&board);
+
+    // Play until the position itself ends the game, no request is sent for a finished game
+    int state;
+    while ((state = board.gameState()) == GameState::ONGOING) {
+        if (!getBotMove(&board)) {
+            return 1;
+        }
         board.printBoard();
         sleep(1); 
     }
+    cout << "Game over: " << GameState::name(state) << endl;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <chess.hpp>
+
+#include <algorithm>
+
+Bitboard ChessBoard::_attackersTo(int square, Bitboard occupied) const {
+    return (Attacks::pawn[PieceColor::WHITE][square] & pieces(PieceColor::BLACK, PieceKind::PAWN))
+         | (Attacks::pawn[PieceColor::BLACK][square] & pieces(PieceColor::WHITE, PieceKind::PAWN))
+         | (Attacks::knight[square] & _byKind[PieceKind::KNIGHT])
+         | (Attacks::king[square] & _byKind[PieceKind::KING])
+         | (Attacks::bishop(square, occupied) & (_byKind[PieceKind::BISHOP] | _byKind[PieceKind::QUEEN]))
+         | (Attacks::rook(square, occupied) & (_byKind[PieceKind::ROOK] | _byKind[PieceKind::QUEEN]));
+}
+
+int ChessBoard::see(Move move) const {
+    if (move.type() == Move::CASTLING) {
+        return 0;
+    }
+
+    int from = move.from();
+    int to = move.to();
+    int side = _squares[from].getColor();
+    int attackerKind = _squares[from].getKind();
+    Bitboard occupied = _occupied ^ squareBB(from);
+
+    // gain[i]: material of the side that moves at step i, if the sequence stopped there
+    int gain[32];
+    int depth = 0;
+    if (move.type() == Move::EN_PASSANT) {
+        occupied ^= squareBB(squareOf(fileOf(to), rankOf(from)));
+        gain[0] = PieceValue::material[PieceKind::PAWN];
+    } else {
+        gain[0] = _squares[to].isEmpty() ? 0 : PieceValue::material[_squares[to].getKind()];
+    }
+    if (move.isPromotion()) {
+        gain[0] += PieceValue::material[move.promotionKind()] - PieceValue::material[PieceKind::PAWN];
+        attackerKind = move.promotionKind();
+    }
+
+    Bitboard diagonal = _byKind[PieceKind::BISHOP] | _byKind[PieceKind::QUEEN];
+    Bitboard straight = _byKind[PieceKind::ROOK] | _byKind[PieceKind::QUEEN];
+    Bitboard attackers = _attackersTo(to, occupied) & occupied;
+
+    while (depth < 31) {
+        side ^= 1;
+        Bitboard ours = attackers & _byColor[side];
+        if (!ours) {
+            break;
+        }
+
+        int kind = PieceKind::PAWN;
+        while (!(ours & _byKind[kind])) {
+            kind++;
+        }
+        Bitboard attacker = ours & _byKind[kind];
+        occupied ^= attacker & (0 - attacker);
+
+        // Removing the attacker may uncover a slider behind it on the same line
+        if (kind == PieceKind::PAWN || kind == PieceKind::BISHOP || kind == PieceKind::QUEEN) {
+            attackers |= Attacks::bishop(to, occupied) & diagonal;
+        }
+        if (kind == PieceKind::ROOK || kind == PieceKind::QUEEN) {
+            attackers |= Attacks::rook(to, occupied) & straight;
+        }
+        attackers &= occupied;
+
+        // The king cannot capture onto a square the other side still defends
+        if (kind == PieceKind::KING && (attackers & _byColor[side ^ 1])) {
+            break;
+        }
+
+        depth++;
+        gain[depth] = PieceValue::material[attackerKind] - gain[depth - 1];
+        attackerKind = kind;
+    }
+
+    // Walk back: each side only continues the exchange when it does not lose by it
+    while (depth > 0) {
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+void ChessBoard::_updateCheckInfo() {
+    int us = (turn == WHITE_TURN) ? PieceColor::WHITE : PieceColor::BLACK;
+    int them = us ^ 1;
+    _checkers = 0;
+    _pinned = 0;
+
+    Bitboard kingBB = pieces(us, PieceKind::KING);
+    if (!kingBB) {
+        return;
+    }
+    int kingSquare = lsb(kingBB);
+    _checkers = _attackersTo(kingSquare, _occupied) & _byColor[them];
+
+    // Our pieces standing alone between the king and an enemy slider
+    Bitboard snipers = (Attacks::rook(kingSquare, 0) & (pieces(them, PieceKind::ROOK) | pieces(them, PieceKind::QUEEN)))
+                     | (Attacks::bishop(kingSquare, 0) & (pieces(them, PieceKind::BISHOP) | pieces(them, PieceKind::QUEEN)));
+    while (snipers) {
+        Bitboard blockers = Attacks::between[kingSquare][popLsb(snipers)] & _occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & _byColor[us])) {
+            _pinned |= blockers;
+        }
+    }
+}
+
+void ChessBoard::generateLegalMoves(MoveList& moves) const {
+    moves.clear();
+
+    int us = (turn == WHITE_TURN) ? PieceColor::WHITE : PieceColor::BLACK;
+    int them = us ^ 1;
+    Bitboard ours = _byColor[us];
+    Bitboard theirs = _byColor[them];
+
+    // Without a king there is nothing to keep safe, every pseudo-legal move is accepted
+    Bitboard kingBB = pieces(us, PieceKind::KING);
+    int kingSquare = kingBB ? lsb(kingBB) : NO_SQUARE;
+    Bitboard checkers = _checkers;
+    Bitboard pinned = _pinned;
+
+    if (kingSquare != NO_SQUARE) {
+        // King moves, the king itself must not shield the squares it steps back to
+        Bitboard withoutKing = _occupied ^ kingBB;
+        Bitboard targets = Attacks::king[kingSquare] & ~ours;
+        while (targets) {
+            int to = popLsb(targets);
+            if (!(_attackersTo(to, withoutKing) & theirs)) {
+                moves.add(Move(kingSquare, to));
+            }
+        }
+
+        // Only the king can answer a double check
+        if (popCount(checkers) > 1) {
+            return;
+        }
+    }
+
+    // Squares a non-king move may land on: block or capture a single checker
+    Bitboard target = ~ours;
+    if (checkers) {
+        target &= Attacks::between[kingSquare][lsb(checkers)] | checkers;
+    }
+
+    // Knights, bishops, rooks and queens
+    Bitboard pieceBB = ours & ~_byKind[PieceKind::PAWN] & ~_byKind[PieceKind::KING];
+    while (pieceBB) {
+        int from = popLsb(pieceBB);
+        int kind = _squares[from].getKind();
+
+        Bitboard targets;
+        switch (kind) {
+            case PieceKind::KNIGHT: targets = Attacks::knight[from]; break;
+            case PieceKind::BISHOP: targets = Attacks::bishop(from, _occupied); break;
+            case PieceKind::ROOK:   targets = Attacks::rook(from, _occupied); break;
+            default:                targets = Attacks::queen(from, _occupied); break;
+        }
+        targets &= target;
+        if (pinned & squareBB(from)) {
+            targets &= Attacks::line[kingSquare][from];
+        }
+
+        while (targets) {
+            moves.add(Move(from, popLsb(targets)));
+        }
+    }
+
+    // Pawns
+    int forward = (us == PieceColor::WHITE) ? 8 : -8;
+    int startRank = (us == PieceColor::WHITE) ? 1 : 6;
+    int promotionRank = (us == PieceColor::WHITE) ? 7 : 0;
+
+    Bitboard pawns = pieces(us, PieceKind::PAWN);
+    while (pawns) {
+        int from = popLsb(pawns);
+
+        Bitboard targets = Attacks::pawn[us][from] & theirs;
+        int push = from + forward;
+        if (push >= 0 && push < SQUARE_NB && !(_occupied & squareBB(push))) {
+            targets |= squareBB(push);
+            if (rankOf(from) == startRank && !(_occupied & squareBB(push + forward))) {
+                targets |= squareBB(push + forward);
+            }
+        }
+        targets &= target;
+        if (pinned & squareBB(from)) {
+            targets &= Attacks::line[kingSquare][from];
+        }
+
+        while (targets) {
+            int to = popLsb(targets);
+            if (rankOf(to) == promotionRank) {
+                for (int kind = PieceKind::QUEEN; kind >= PieceKind::KNIGHT; kind--) {
+                    moves.add(Move(from, to, Move::PROMOTION, kind));
+                }
+            } else {
+                moves.add(Move(from, to));
+            }
+        }
+    }
+
+    // En passant, checked by playing it on the occupancy since it removes two pieces from one rank
+    if (enPassantTarget != NO_SQUARE && !(_occupied & squareBB(enPassantTarget))) {
+        int capturedSquare = enPassantTarget - forward;
+        if (capturedSquare >= 0 && capturedSquare < SQUARE_NB && (pieces(them, PieceKind::PAWN) & squareBB(capturedSquare))) {
+            Bitboard attackers = Attacks::pawn[them][enPassantTarget] & pieces(us, PieceKind::PAWN);
+            while (attackers) {
+                int from = popLsb(attackers);
+                if (kingSquare != NO_SQUARE) {
+                    Bitboard occupied = (_occupied ^ squareBB(from) ^ squareBB(capturedSquare)) | squareBB(enPassantTarget);
+                    if (_attackersTo(kingSquare, occupied) & theirs & ~squareBB(capturedSquare)) {
+                        continue;
+                    }
+                }
+                moves.add(Move(from, enPassantTarget, Move::EN_PASSANT));
+            }
+        }
+    }
+
+    // Castling, the rook must still be home and the king may not pass through an attacked square
+    if (kingSquare == NO_SQUARE || checkers) {
+        return;
+    }
+
+    int backRank = (us == PieceColor::WHITE) ? 0 : 7;
+    int homeSquare = squareOf(4, backRank);
+    if (kingSquare != homeSquare) {
+        return;
+    }
+
+    bool kingSide = (us == PieceColor::WHITE) ? wck : bck;
+    bool queenSide = (us == PieceColor::WHITE) ? wcq : bcq;
+    Bitboard rooks = pieces(us, PieceKind::ROOK);
+
+    if (kingSide
+        && (rooks & squareBB(squareOf(7, backRank)))
+        && !(_occupied & (squareBB(squareOf(5, backRank)) | squareBB(squareOf(6, backRank))))
+        && !(_attackersTo(squareOf(5, backRank), _occupied) & theirs)
+        && !(_attackersTo(squareOf(6, backRank), _occupied) & theirs)) {
+        moves.add(Move(kingSquare, squareOf(6, backRank), Move::CASTLING));
+    }
+
+    if (queenSide
+        && (rooks & squareBB(squareOf(0, backRank)))
+        && !(_occupied & (squareBB(squareOf(1, backRank)) | squareBB(squareOf(2, backRank)) | squareBB(squareOf(3, backRank))))
+        && !(_attackersTo(squareOf(3, backRank), _occupied) & theirs)
+        && !(_attackersTo(squareOf(2, backRank), _occupied) & theirs)) {
+        moves.add(Move(kingSquare, squareOf(2, backRank), Move::CASTLING));
+    }
+}
@@ -0,0 +1,103 @@
+#include <packedPosition.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+static_assert(is_trivially_copyable<PackedPosition>::value, "PackedPosition is written and read as raw bytes");
+
+/// @brief  Largest halfmove clock and move count the state word can hold, larger values are clamped
+#define PACKED_MAX_HALFMOVE_CLOCK 0x3FFF
+#define PACKED_MAX_MOVE_COUNT 0x1FFFF
+
+uint64_t PackedPosition::hash() const {
+    uint64_t words[4];
+    memcpy(words, this, sizeof(words));
+
+    uint64_t h = 0;
+    for (uint64_t word : words) {
+        h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+bool PackedPosition::operator==(const PackedPosition& other) const {
+    return memcmp(this, &other, sizeof(PackedPosition)) == 0;
+}
+
+bool ChessBoard::toPacked(PackedPosition& packed) const {
+    if (popCount(_occupied) > 32) {
+        return false;
+    }
+
+    packed.occupied = _occupied;
+    memset(packed.pieces, 0, sizeof(packed.pieces));
+    Bitboard occupied = _occupied;
+    for (int i = 0; occupied; i++) {
+        Piece piece = _squares[popLsb(occupied)];
+        uint8_t code = static_cast<uint8_t>(piece.getColor() * 6 + piece.getKind() + 1);
+        packed.pieces[i / 2] |= static_cast<uint8_t>(code << (4 * (i & 1)));
+    }
+
+    uint64_t state = (turn == BLACK_TURN) ? 1 : 0;
+    state |= uint64_t(_castlingBits()) << 1;
+    // Same rule as the Zobrist key, a target nobody can capture is not part of the position
+    if (_enPassantKey()) {
+        state |= (uint64_t(1) << 5) | (uint64_t(fileOf(enPassantTarget)) << 6);
+    }
+    state |= uint64_t(min(max(halfmoveClock, 0), PACKED_MAX_HALFMOVE_CLOCK)) << 9;
+    state |= uint64_t(min(max(moveCount, 0), PACKED_MAX_MOVE_COUNT)) << 23;
+    packed.state = state;
+    return true;
+}
+
+bool ChessBoard::fromPacked(const PackedPosition& packed) {
+    int count = popCount(packed.occupied);
+    if (count > 32 || (packed.state >> 40)) {
+        return false;
+    }
+
+    // Decode and validate everything before touching the board
+    for (int i = count; i < 32; i++) {
+        if ((packed.pieces[i / 2] >> (4 * (i & 1))) & 0x0F) {
+            return false;
+        }
+    }
+    Piece squares[SQUARE_NB];
+    Bitboard occupied = packed.occupied;
+    for (int i = 0; occupied; i++) {
+        int code = (packed.pieces[i / 2] >> (4 * (i & 1))) & 0x0F;
+        if (code < 1 || code > 12) {
+            return false;
+        }
+        squares[popLsb(occupied)] = Piece::make((code - 1) / 6, (code - 1) % 6);
+    }
+
+    uint64_t state = packed.state;
+    char newTurn = (state & 1) ? BLACK_TURN : WHITE_TURN;
+    int newEnPassant = NO_SQUARE;
+    if (state & (uint64_t(1) << 5)) {
+        newEnPassant = squareOf(static_cast<int>((state >> 6) & 7), newTurn == WHITE_TURN ? 5 : 2);
+    }
+    int newMoveCount = static_cast<int>((state >> 23) & PACKED_MAX_MOVE_COUNT);
+    if (newMoveCount < 1 || !_checkPosition(squares, newTurn, newEnPassant).ok()) {
+        return false;
+    }
+
+    _clearBoard();
+    _undo.clear();
+    for (int square = 0; square < SQUARE_NB; square++) {
+        if (!squares[square].isEmpty()) {
+            _addPiece(square, squares[square]);
+        }
+    }
+    turn = newTurn;
+    _setCastlingBits(static_cast<uint8_t>((state >> 1) & 0x0F));
+    enPassantTarget = newEnPassant;
+    halfmoveClock = static_cast<int>((state >> 9) & PACKED_MAX_HALFMOVE_CLOCK);
+    moveCount = newMoveCount;
+    refreshKey();
+    return true;
+}